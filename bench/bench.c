@@ -0,0 +1,162 @@
+/*
+	Name: Guy Feigin
+	Exercise: Benchmark harness
+	File Type: Source code
+	Reviewer:
+	Last Updated: Sat 17 Oct 2026 21:34:50
+*/
+
+#define _POSIX_C_SOURCE (200112L)
+
+#include <stdio.h> /* printf() */
+#include <stdlib.h> /* exit() */
+#include <string.h> /* strstr() */
+#include <time.h> /* clock_gettime() */
+#include <stdatomic.h> /* atomic_size_t */
+
+#include "bench.h" /* bench_op_t */
+
+#define BATCH (16)
+
+/* The allocator glibc itself is built on, malloc() below forwards to it */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n_members, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static atomic_size_t allocs;
+static const char *filter = NULL;
+
+/*							  Global Functions								  */
+/******************************************************************************/
+
+void *malloc(size_t size)
+{
+	atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+
+	return (__libc_malloc(size));
+}
+
+void *calloc(size_t n_members, size_t size)
+{
+	atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+
+	return (__libc_calloc(n_members, size));
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	atomic_fetch_add_explicit(&allocs, 1, memory_order_relaxed);
+
+	return (__libc_realloc(ptr, size));
+}
+
+void BenchInit(int argc, char *argv[])
+{
+	filter = argc > 1 ? argv[1] : NULL;
+}
+
+int BenchIsSelected(const char *name)
+{
+	return (!filter || NULL != strstr(name, filter));
+}
+
+void BenchRun(const char *name, size_t size, size_t n_ops, bench_op_t op,
+			  void *ctx)
+{
+	hist_t *batch_ns = NULL;
+	size_t start_allocs = 0;
+	double start = 0;
+	double batch_start = 0;
+	size_t batch_end = 0;
+	size_t i = 0;
+	size_t j = 0;
+
+	if (!BenchIsSelected(name))
+	{
+		return;
+	}
+
+	batch_ns = HistCreate();
+	if (!batch_ns)
+	{
+		fprintf(stderr, "%s: allocation failed\n", name);
+		exit(EXIT_FAILURE);
+	}
+
+	start_allocs = BenchAllocs();
+	start = BenchNowNs();
+
+	for (i = 0; i < n_ops; i = batch_end)
+	{
+		batch_end = i + BATCH < n_ops ? i + BATCH : n_ops;
+
+		batch_start = BenchNowNs();
+		for (j = i; j < batch_end; ++j)
+		{
+			op(ctx, j);
+		}
+		HistRecord(batch_ns, (BenchNowNs() - batch_start) / (batch_end - i));
+	}
+
+	BenchReport(name, size, n_ops, BenchNowNs() - start,
+				BenchAllocs() - start_allocs, batch_ns);
+
+	HistDestroy(batch_ns);
+}
+
+void BenchReport(const char *name, size_t size, size_t n_ops, double total_ns,
+				 size_t allocs, const hist_t *batch_ns)
+{
+	if (!BenchIsSelected(name) || 0 == n_ops)
+	{
+		return;
+	}
+
+	printf("{\"bench\":\"%s\",\"size\":%lu,\"ops\":%lu,\"ns_per_op\":%.1f,"
+		   "\"allocs_per_op\":%.2f", name, (unsigned long)size,
+		   (unsigned long)n_ops, total_ns / n_ops, (double)allocs / n_ops);
+
+	if (batch_ns)
+	{
+		printf(",\"p50_ns\":%lu,\"p90_ns\":%lu,\"p99_ns\":%lu,\"max_ns\":%lu",
+			   (unsigned long)HistPercentile(batch_ns, 50),
+			   (unsigned long)HistPercentile(batch_ns, 90),
+			   (unsigned long)HistPercentile(batch_ns, 99),
+			   (unsigned long)HistMax(batch_ns));
+	}
+	else
+	{
+		printf(",\"p50_ns\":null,\"p90_ns\":null,\"p99_ns\":null,"
+			   "\"max_ns\":null");
+	}
+
+	printf("}\n");
+	fflush(stdout);
+}
+
+void BenchReportValue(const char *name, size_t size, const char *key,
+					  double value)
+{
+	if (!BenchIsSelected(name))
+	{
+		return;
+	}
+
+	printf("{\"bench\":\"%s\",\"size\":%lu,\"%s\":%.1f}\n", name,
+		   (unsigned long)size, key, value);
+	fflush(stdout);
+}
+
+size_t BenchAllocs(void)
+{
+	return (atomic_load_explicit(&allocs, memory_order_relaxed));
+}
+
+double BenchNowNs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec * 1e9 + now.tv_nsec);
+}
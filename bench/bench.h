@@ -0,0 +1,83 @@
+/*
+	Name: Guy Feigin
+	Exercise: Benchmark harness
+	File Type: Header
+	Reviewer:
+	Last Updated: Sat 17 Oct 2026 21:34:50
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h> /* size_t */
+
+#include "hist.h" /* hist_t */
+
+/******************************************************************************/
+/* A tiny harness shared by the benchmarks. Every measurement is printed as   */
+/* a single JSON object per line, so runs can be diffed and tracked over 	  */
+/* time:																	  */
+/*																			  */
+/* {"bench":"dlist/insert","size":1000,"ops":1000,"ns_per_op":14.2,			  */
+/*  "allocs_per_op":1.00,"p50_ns":13,"p90_ns":15,"p99_ns":31,"max_ns":250}	  */
+/*																			  */
+/* Operations are timed in batches of 16, the percentiles are of the 		  */
+/* average time of an operation within a batch. Allocations are counted by	  */
+/* interposing malloc, calloc and realloc, the shared libraries included.	  */
+
+/******************************************************************************/
+/* Description:  A single operation, i is its index among the operations of  */
+/*				 the run												  	  */
+typedef void (*bench_op_t)(void *ctx, size_t i);
+
+/******************************************************************************/
+/* Description:  Sets up the harness, argv[1], when given, is a substring 	  */
+/*				 that selects the benchmarks to be run						  */
+void BenchInit(int argc, char *argv[]);
+
+/******************************************************************************/
+/* Description:  Returns 1 if the benchmark was selected, 0 otherwise		  */
+int BenchIsSelected(const char *name);
+
+/******************************************************************************/
+/* Description:  Runs n_ops operations, times them and prints the result	  */
+/* Arguments:    name - name of the benchmark, "group/operation"			  */
+/*				 size - the size of the structure it runs on				  */
+/*				 n_ops - number of operations								  */
+/*				 op - the operation											  */
+/*				 ctx - parameter to be sent to the operation				  */
+/* Return value: None														  */
+void BenchRun(const char *name, size_t size, size_t n_ops, bench_op_t op,
+			  void *ctx);
+
+/******************************************************************************/
+/* Description:  Prints the result of a measurement taken by the caller, for  */
+/*				 operations that can't be timed one by one					  */
+/* Arguments:    name, size, n_ops - as in BenchRun							  */
+/*				 total_ns - the time all the operations took				  */
+/*				 allocs - the allocations all the operations made			  */
+/*				 batch_ns - time of an operation per batch, NULL if unknown	  */
+/* Return value: None														  */
+void BenchReport(const char *name, size_t size, size_t n_ops, double total_ns,
+				 size_t allocs, const hist_t *batch_ns);
+
+/******************************************************************************/
+/* Description:  Prints a single measured value that isn't the time of an	  */
+/*				 operation, such as the memory used by another process:		  */
+/*				 {"bench":"supervisor/rss","size":1000,"rss_kb":5120.0}		  */
+/* Arguments:    name, size - as in BenchRun								  */
+/*				 key - what the value is, with its unit						  */
+/*				 value - the value											  */
+/* Return value: None														  */
+void BenchReportValue(const char *name, size_t size, const char *key,
+					  double value);
+
+/******************************************************************************/
+/* Description:  Returns the number of allocations made so far by the process */
+size_t BenchAllocs(void);
+
+/******************************************************************************/
+/* Description:  Returns the monotonic clock in nanoseconds					  */
+double BenchNowNs(void);
+
+#endif /* BENCH_H */
@@ -0,0 +1,84 @@
+/*
+	Name: Guy Feigin
+	Exercise: Doubly linked list benchmark
+	File Type: Source code
+	Reviewer:
+	Last Updated: Sat 17 Oct 2026 21:34:50
+*/
+
+#include <stdio.h> /* fprintf() */
+#include <stdlib.h> /* exit() */
+
+#include "dlist.h" /* dlist_t */
+#include "bench.h" /* BenchRun() */
+
+#define MAX_LOOKUPS (1000)
+
+static int IsMatch(const void *data, void *param);
+static void Insert(void *ctx, size_t i);
+static void Find(void *ctx, size_t i);
+static void Count(void *ctx, size_t i);
+static void BenchSize(size_t size);
+
+int main(int argc, char *argv[])
+{
+	static const size_t sizes[] = {100, 1000, 10000};
+	size_t i = 0;
+
+	BenchInit(argc, argv);
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		BenchSize(sizes[i]);
+	}
+
+	return (0);
+}
+
+static int IsMatch(const void *data, void *param)
+{
+	return (data == param);
+}
+
+static void Insert(void *ctx, size_t i)
+{
+	dlist_t *list = (dlist_t *)ctx;
+
+	DListInsert(DListEnd(list), (void *)(i + 1));
+}
+
+/* Looks up keys spread over the whole list */
+static void Find(void *ctx, size_t i)
+{
+	dlist_t *list = (dlist_t *)ctx;
+	size_t size = (size_t)DListGetData(DListPrev(DListEnd(list)));
+
+	DListFind(DListBegin(list), DListEnd(list), IsMatch,
+			  (void *)(i * 7919 % size + 1));
+}
+
+static void Count(void *ctx, size_t i)
+{
+	(void)i;
+
+	DListCount((dlist_t *)ctx);
+}
+
+static void BenchSize(size_t size)
+{
+	dlist_t *list = DListCreate();
+	size_t lookups = size < MAX_LOOKUPS ? size : MAX_LOOKUPS;
+
+	if (!list)
+	{
+		fprintf(stderr, "dlist: allocation failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Holds 1..size once filled, in order */
+	BenchRun("dlist/insert", size, size, Insert, list);
+	BenchRun("dlist/find", size, lookups, Find, list);
+	BenchRun("dlist/count", size, lookups, Count, list);
+
+	DListDestroy(list);
+}
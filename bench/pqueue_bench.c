@@ -0,0 +1,135 @@
+/*
+	Name: Guy Feigin
+	Exercise: Priority queue benchmark
+	File Type: Source code
+	Reviewer:
+	Last Updated: Sat 17 Oct 2026 21:34:50
+*/
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* rand() */
+
+#include "pqueue.h" /* pq_t */
+#include "bench.h" /* BenchRun() */
+
+#define ERASES (100)
+#define NAME_SIZE (64)
+
+typedef struct pq_ctx
+{
+	pq_t *pq;
+	size_t *keys;
+} pq_ctx_t;
+
+typedef struct engine
+{
+	const char *name;
+	pq_type_t type;
+} engine_t;
+
+static int Compare(const void *data, const void *param);
+static int IsMatch(const void *data, void *param);
+static void Enqueue(void *ctx, size_t i);
+static void Dequeue(void *ctx, size_t i);
+static void Erase(void *ctx, size_t i);
+static void Fill(pq_ctx_t *ctx, size_t size);
+static void BenchEngine(const engine_t *engine, size_t size);
+
+int main(int argc, char *argv[])
+{
+	static const size_t sizes[] = {100, 1000, 10000};
+	static const engine_t engines[] = {
+		{"srtlist", PQ_SRTLIST},
+		{"heap", PQ_HEAP}
+	};
+	size_t i = 0;
+	size_t j = 0;
+
+	BenchInit(argc, argv);
+	srand(1);
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		for (j = 0; j < sizeof(engines) / sizeof(engines[0]); ++j)
+		{
+			BenchEngine(&engines[j], sizes[i]);
+		}
+	}
+
+	return (0);
+}
+
+static int Compare(const void *data, const void *param)
+{
+	return (((size_t)data > (size_t)param) - ((size_t)data < (size_t)param));
+}
+
+static int IsMatch(const void *data, void *param)
+{
+	return (data == param);
+}
+
+/* Keys are unique, so every one of them can be erased later on */
+static void Enqueue(void *ctx, size_t i)
+{
+	pq_ctx_t *pq_ctx = (pq_ctx_t *)ctx;
+
+	pq_ctx->keys[i] = ((size_t)rand() << 20) + i + 1;
+	PQEnqueue(pq_ctx->pq, (void *)pq_ctx->keys[i]);
+}
+
+static void Dequeue(void *ctx, size_t i)
+{
+	(void)i;
+
+	PQDequeue(((pq_ctx_t *)ctx)->pq);
+}
+
+/* Erases distinct keys spread over the whole queue */
+static void Erase(void *ctx, size_t i)
+{
+	pq_ctx_t *pq_ctx = (pq_ctx_t *)ctx;
+	size_t size = PQCount(pq_ctx->pq) + i;
+
+	PQErase(pq_ctx->pq, IsMatch, (void *)pq_ctx->keys[i * 7919 % size]);
+}
+
+/* Refills the queue with size fresh keys, whatever a filter left in it */
+static void Fill(pq_ctx_t *ctx, size_t size)
+{
+	size_t i = 0;
+
+	PQClear(ctx->pq);
+	for (i = 0; i < size; ++i)
+	{
+		Enqueue(ctx, i);
+	}
+}
+
+static void BenchEngine(const engine_t *engine, size_t size)
+{
+	char name[NAME_SIZE];
+	pq_ctx_t ctx;
+
+	ctx.pq = PQCreateType(Compare, engine->type);
+	ctx.keys = (size_t *)malloc(size * sizeof(size_t));
+	if (!ctx.pq || !ctx.keys)
+	{
+		fprintf(stderr, "pqueue/%s: allocation failed\n", engine->name);
+		exit(EXIT_FAILURE);
+	}
+
+	snprintf(name, NAME_SIZE, "pqueue/%s/enqueue", engine->name);
+	BenchRun(name, size, size, Enqueue, &ctx);
+
+	Fill(&ctx, size);
+	snprintf(name, NAME_SIZE, "pqueue/%s/dequeue", engine->name);
+	BenchRun(name, size, size, Dequeue, &ctx);
+
+	Fill(&ctx, size);
+	snprintf(name, NAME_SIZE, "pqueue/%s/erase", engine->name);
+	BenchRun(name, size, ERASES < size ? ERASES : size, Erase, &ctx);
+
+	PQDestroy(ctx.pq);
+	free(ctx.keys);
+}
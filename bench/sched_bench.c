@@ -0,0 +1,151 @@
+/*
+	Name: Guy Feigin
+	Exercise: Scheduler benchmark
+	File Type: Source code
+	Reviewer:
+	Last Updated: Sat 17 Oct 2026 11:40:18
+*/
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* malloc() */
+
+#include "scheduler.h" /* scheduler_t */
+#include "bench.h" /* BenchRun() */
+
+#define MAX_INTERVAL (3600)
+#define CANCELS (100)
+#define NAME_SIZE (64)
+
+typedef scheduler_t *(*create_func_t)(void);
+
+typedef struct backend
+{
+	const char *name;
+	create_func_t create;
+} backend_t;
+
+typedef struct sched_ctx
+{
+	scheduler_t *sched;
+	ilrd_uid_t *uids;
+	size_t n_tasks;
+} sched_ctx_t;
+
+static int RunOnce(void *param);
+static int Repeat(void *param);
+static void Add(void *ctx, size_t i);
+static void Remove(void *ctx, size_t i);
+static void BenchBackend(const backend_t *backend, size_t n_tasks);
+
+int main(int argc, char *argv[])
+{
+	static const size_t sizes[] = {1000, 100000, 1000000};
+	static const backend_t backends[] = {
+		{"pqueue", SchedCreate},
+		{"wheel", SchedCreateWheel}
+	};
+	size_t i = 0;
+	size_t j = 0;
+
+	BenchInit(argc, argv);
+	srand(1);
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		for (j = 0; j < sizeof(backends) / sizeof(backends[0]); ++j)
+		{
+			BenchBackend(&backends[j], sizes[i]);
+		}
+	}
+
+	return (0);
+}
+
+static int RunOnce(void *param)
+{
+	(void)param;
+
+	return (SUCCESS);
+}
+
+static int Repeat(void *param)
+{
+	(void)param;
+
+	return (REPEAT);
+}
+
+/* Periodic timers spread over an hour, as heartbeats and retries are */
+static void Add(void *ctx, size_t i)
+{
+	sched_ctx_t *sched_ctx = (sched_ctx_t *)ctx;
+
+	sched_ctx->uids[i] = SchedAddTask(sched_ctx->sched,
+									  1 + rand() % MAX_INTERVAL, Repeat,
+									  NULL, NULL, NULL);
+}
+
+/* Cancels distinct tasks spread over the whole scheduler */
+static void Remove(void *ctx, size_t i)
+{
+	sched_ctx_t *sched_ctx = (sched_ctx_t *)ctx;
+
+	SchedRemoveTask(sched_ctx->sched,
+					sched_ctx->uids[i * 7919 % sched_ctx->n_tasks]);
+}
+
+static void BenchBackend(const backend_t *backend, size_t n_tasks)
+{
+	char name[NAME_SIZE];
+	sched_ctx_t ctx;
+	size_t start_allocs = 0;
+	double start = 0;
+	size_t i = 0;
+
+	ctx.n_tasks = n_tasks;
+	ctx.uids = (ilrd_uid_t *)malloc(n_tasks * sizeof(ilrd_uid_t));
+	ctx.sched = backend->create();
+	if (!ctx.uids || !ctx.sched)
+	{
+		fprintf(stderr, "%s: allocation failed\n", backend->name);
+		exit(EXIT_FAILURE);
+	}
+
+	/* Removal needs the tasks even when adding isn't measured */
+	snprintf(name, NAME_SIZE, "sched/%s/add", backend->name);
+	if (BenchIsSelected(name))
+	{
+		BenchRun(name, n_tasks, n_tasks, Add, &ctx);
+	}
+	else
+	{
+		for (i = 0; i < n_tasks; ++i)
+		{
+			Add(&ctx, i);
+		}
+	}
+
+	snprintf(name, NAME_SIZE, "sched/%s/remove", backend->name);
+	BenchRun(name, n_tasks, CANCELS, Remove, &ctx);
+
+	SchedClear(ctx.sched);
+
+	/* Tasks that are all due now, each one runs once and expires */
+	snprintf(name, NAME_SIZE, "sched/%s/run", backend->name);
+	if (BenchIsSelected(name))
+	{
+		for (i = 0; i < n_tasks; ++i)
+		{
+			SchedAddTask(ctx.sched, 0, RunOnce, NULL, NULL, NULL);
+		}
+
+		start_allocs = BenchAllocs();
+		start = BenchNowNs();
+		SchedRun(ctx.sched);
+		BenchReport(name, n_tasks, n_tasks, BenchNowNs() - start,
+					BenchAllocs() - start_allocs, NULL);
+	}
+
+	SchedDestroy(ctx.sched);
+	free(ctx.uids);
+}
@@ -0,0 +1,111 @@
+/*
+	Name: Guy Feigin
+	Exercise: Spawn benchmark
+	File Type: Source code
+	Reviewer:
+	Last Updated: Sun 18 Oct 2026 01:20:07
+*/
+
+#define _GNU_SOURCE /* MADV_NOHUGEPAGE */
+
+#include <stdio.h> /* fprintf() */
+#include <stdlib.h> /* EXIT_FAILURE */
+#include <string.h> /* memset() */
+#include <unistd.h> /* fork() */
+#include <spawn.h> /* posix_spawn() */
+#include <sys/wait.h> /* waitpid() */
+#include <sys/mman.h> /* mmap() */
+
+#include "bench.h" /* BenchRun() */
+
+#define SPAWNS (32)
+#define MB (1024 * 1024)
+
+extern char **environ;
+
+static void ForkExec(void *ctx, size_t i);
+static void PosixSpawn(void *ctx, size_t i);
+static void BenchRss(size_t rss_mb);
+
+static char *const argv[] = {"/bin/true", NULL};
+
+int main(int argc, char *argv[])
+{
+	static const size_t sizes_mb[] = {0, 64, 512, 2048};
+	size_t i = 0;
+
+	BenchInit(argc, argv);
+
+	for (i = 0; i < sizeof(sizes_mb) / sizeof(sizes_mb[0]); ++i)
+	{
+		BenchRss(sizes_mb[i]);
+	}
+
+	return (0);
+}
+
+/* Spawning the way Fork and Revive in watchdog_client.c used to */
+static void ForkExec(void *ctx, size_t i)
+{
+	pid_t pid = fork();
+
+	(void)ctx;
+	(void)i;
+
+	if (0 == pid)
+	{
+		execv(argv[0], argv);
+		_exit(EXIT_FAILURE);
+	}
+
+	waitpid(pid, NULL, 0);
+}
+
+static void PosixSpawn(void *ctx, size_t i)
+{
+	pid_t pid = 0;
+
+	(void)ctx;
+	(void)i;
+
+	if (0 == posix_spawn(&pid, argv[0], NULL, NULL, argv, environ))
+	{
+		waitpid(pid, NULL, 0);
+	}
+}
+
+/* The size of a run is the resident memory of the parent, in MB */
+static void BenchRss(size_t rss_mb)
+{
+	char *ballast = MAP_FAILED;
+
+	if (!BenchIsSelected("spawn/fork_exec") && 
+		!BenchIsSelected("spawn/posix_spawn"))
+	{
+		return;
+	}
+
+	/* Touched in 4KB pages, as a heap grown by malloc mostly is */
+	if (0 != rss_mb)
+	{
+		ballast = (char *)mmap(NULL, rss_mb * MB, PROT_READ | PROT_WRITE,
+							   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (MAP_FAILED == ballast)
+		{
+			fprintf(stderr, "spawn: can't allocate %lu MB\n", 
+					(unsigned long)rss_mb);
+			return;
+		}
+
+		madvise(ballast, rss_mb * MB, MADV_NOHUGEPAGE);
+		memset(ballast, 1, rss_mb * MB);
+	}
+
+	BenchRun("spawn/fork_exec", rss_mb, SPAWNS, ForkExec, NULL);
+	BenchRun("spawn/posix_spawn", rss_mb, SPAWNS, PosixSpawn, NULL);
+
+	if (MAP_FAILED != ballast)
+	{
+		munmap(ballast, rss_mb * MB);
+	}
+}
@@ -0,0 +1,112 @@
+/*
+	Name: Guy Feigin
+	Exercise: Sorted list benchmark
+	File Type: Source code
+	Reviewer:
+	Last Updated: Sat 17 Oct 2026 21:34:50
+*/
+
+#include <stdio.h> /* fprintf() */
+#include <stdlib.h> /* rand() */
+
+#include "srtlist.h" /* srtlist_t */
+#include "bench.h" /* BenchRun() */
+
+#define MERGES (16)
+
+typedef struct merge_ctx
+{
+	srtlist_t *dest[MERGES];
+	srtlist_t *src[MERGES];
+} merge_ctx_t;
+
+static int Compare(const void *data, const void *param);
+static srtlist_t *CreateList(void);
+static void Insert(void *ctx, size_t i);
+static void Merge(void *ctx, size_t i);
+static void BenchSize(size_t size);
+
+int main(int argc, char *argv[])
+{
+	static const size_t sizes[] = {100, 1000, 10000};
+	size_t i = 0;
+
+	BenchInit(argc, argv);
+	srand(1);
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		BenchSize(sizes[i]);
+	}
+
+	return (0);
+}
+
+static int Compare(const void *data, const void *param)
+{
+	return (((size_t)data > (size_t)param) - ((size_t)data < (size_t)param));
+}
+
+static srtlist_t *CreateList(void)
+{
+	srtlist_t *list = SrtListCreate(Compare);
+	if (!list)
+	{
+		fprintf(stderr, "srtlist: allocation failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	return (list);
+}
+
+static void Insert(void *ctx, size_t i)
+{
+	(void)i;
+
+	SrtListInsert((srtlist_t *)ctx, (void *)((size_t)rand() + 1));
+}
+
+static void Merge(void *ctx, size_t i)
+{
+	merge_ctx_t *merge = (merge_ctx_t *)ctx;
+
+	SrtListMerge(merge->dest[i], merge->src[i]);
+}
+
+static void BenchSize(size_t size)
+{
+	srtlist_t *list = CreateList();
+	merge_ctx_t merge;
+	size_t i = 0;
+	size_t j = 0;
+
+	BenchRun("srtlist/insert", size, size, Insert, list);
+	SrtListDestroy(list);
+
+	if (!BenchIsSelected("srtlist/merge"))
+	{
+		return;
+	}
+
+	/* Pairs of interleaving lists of size / 2 each */
+	for (i = 0; i < MERGES; ++i)
+	{
+		merge.dest[i] = CreateList();
+		merge.src[i] = CreateList();
+
+		/* Descending, so every insert lands at the front */
+		for (j = size / 2; j > 0; --j)
+		{
+			SrtListInsert(merge.dest[i], (void *)(2 * j));
+			SrtListInsert(merge.src[i], (void *)(2 * j + 1));
+		}
+	}
+
+	BenchRun("srtlist/merge", size, MERGES, Merge, &merge);
+
+	for (i = 0; i < MERGES; ++i)
+	{
+		SrtListDestroy(merge.dest[i]);
+		SrtListDestroy(merge.src[i]);
+	}
+}
@@ -0,0 +1,241 @@
+/*
+	Name: Guy Feigin
+	Exercise: Watchdog supervisor benchmark
+	File Type: Source code
+	Reviewer:
+	Last Updated: Sun 18 Oct 2026 00:12:40
+*/
+
+#define _POSIX_C_SOURCE (200112L)
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* exit() */
+#include <string.h> /* strncmp() */
+#include <signal.h> /* kill() */
+#include <time.h> /* clock_getcpuclockid() */
+#include <unistd.h> /* fork() */
+#include <sys/wait.h> /* waitpid() */
+#include <sys/resource.h> /* setrlimit() */
+
+#include "wd_shm.h" /* wd_shm_t */
+#include "wd_supervisor.h" /* WDSupervisorRegister() */
+#include "bench.h" /* BenchReport() */
+
+#define HEARTBEAT_MS (100)
+#define MISS_THRESHOLD (1000) /* The clients are all us, never kill them */
+#define FALSE_POSITIVE_PPM (1) /* Nor for a late beat, as far as it goes */
+#define WINDOW_MS (2000)
+#define RETRIES (100)
+#define PATH_SIZE (64)
+#define LINE_SIZE (256)
+
+typedef struct client
+{
+	wd_shm_t *shm;
+	int fd;
+} client_t;
+
+static void RaiseFdLimit(void);
+static pid_t StartSupervisor(const char *path);
+static void BenchClients(size_t n_clients);
+static double CpuNs(pid_t pid);
+static double RssKb(pid_t pid);
+static void SleepMs(long ms);
+
+int main(int argc, char *argv[])
+{
+	static const size_t sizes[] = {1, 10, 100, 1000, 4000};
+	size_t i = 0;
+
+	BenchInit(argc, argv);
+	RaiseFdLimit();
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		BenchClients(sizes[i]);
+	}
+
+	return (0);
+}
+
+/* Every client costs two fds on both ends */
+static void RaiseFdLimit(void)
+{
+	struct rlimit limit;
+
+	if (0 == getrlimit(RLIMIT_NOFILE, &limit))
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+}
+
+static pid_t StartSupervisor(const char *path)
+{
+	wd_supervisor_t *sup = NULL;
+	pid_t pid = fork();
+
+	if (0 != pid)
+	{
+		return (pid);
+	}
+
+	sup = WDSupervisorCreate(path);
+	if (!sup)
+	{
+		_exit(EXIT_FAILURE);
+	}
+
+	WDSupervisorRun(sup);
+	WDSupervisorDestroy(sup);
+	_exit(EXIT_SUCCESS);
+}
+
+/*
+	Registers n clients, all of them beating from this process, and measures
+	the CPU time the supervisor spends on them over a window and its RSS
+*/
+static void BenchClients(size_t n_clients)
+{
+	static char *const argv[] = {"true", NULL};
+	static const wd_restart_policy_t restart = {1, 1000, 1000, 1000};
+	char path[PATH_SIZE];
+	client_t *clients = NULL;
+	size_t start_allocs = 0;
+	double start = 0;
+	double start_cpu = 0;
+	double end = 0;
+	pid_t pid = 0;
+	size_t i = 0;
+	size_t retry = 0;
+
+	if (!BenchIsSelected("supervisor/register") && 
+		!BenchIsSelected("supervisor/cpu") && 
+		!BenchIsSelected("supervisor/rss"))
+	{
+		return;
+	}
+
+	clients = (client_t *)calloc(n_clients, sizeof(client_t));
+	snprintf(path, PATH_SIZE, "/tmp/supervisor_bench.%d", (int)getpid());
+	pid = StartSupervisor(path);
+	if (!clients || -1 == pid)
+	{
+		fprintf(stderr, "supervisor: setup failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	start_allocs = BenchAllocs();
+	start = BenchNowNs();
+	for (i = 0; i < n_clients; ++i)
+	{
+		clients[i].shm = WDShmCreate();
+		clients[i].fd = -1;
+
+		/* The first one may come before the supervisor listens */
+		for (retry = 0; clients[i].shm && -1 == clients[i].fd && 
+			 retry < RETRIES; ++retry)
+		{
+			clients[i].fd = WDSupervisorRegister(path, 
+												 WDShmGetFd(clients[i].shm),
+												 argv, HEARTBEAT_MS, 
+												 MISS_THRESHOLD, 
+												 FALSE_POSITIVE_PPM, &restart);
+			if (-1 == clients[i].fd && 0 == i)
+			{
+				SleepMs(10);
+			}
+		}
+
+		if (-1 == clients[i].fd)
+		{
+			fprintf(stderr, "supervisor: registration %lu failed\n", 
+					(unsigned long)i);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	BenchReport("supervisor/register", n_clients, n_clients, 
+				BenchNowNs() - start, BenchAllocs() - start_allocs, NULL);
+
+	start_cpu = CpuNs(pid);
+	start = BenchNowNs();
+	for (end = start + WINDOW_MS * 1e6; BenchNowNs() < end; )
+	{
+		for (i = 0; i < n_clients; ++i)
+		{
+			WDShmBeat(clients[i].shm, WD_SIDE_USER);
+		}
+
+		SleepMs(HEARTBEAT_MS);
+	}
+
+	BenchReportValue("supervisor/cpu", n_clients, "cpu_ns_per_check", 
+					 (CpuNs(pid) - start_cpu) / 
+					 (n_clients * (WINDOW_MS / HEARTBEAT_MS)));
+	BenchReportValue("supervisor/cpu", n_clients, "cpu_percent", 
+					 (CpuNs(pid) - start_cpu) * 100 / (BenchNowNs() - start));
+	BenchReportValue("supervisor/rss", n_clients, "rss_kb", RssKb(pid));
+
+	/* Stopped clients are let go rather than revived */
+	for (i = 0; i < n_clients; ++i)
+	{
+		WDShmStop(clients[i].shm, WD_SIDE_WD);
+		close(clients[i].fd);
+		WDShmDetach(clients[i].shm);
+	}
+
+	kill(pid, SIGTERM);
+	waitpid(pid, NULL, 0);
+	free(clients);
+}
+
+static double CpuNs(pid_t pid)
+{
+	struct timespec cpu = {0};
+	clockid_t clock_id;
+
+	if (0 != clock_getcpuclockid(pid, &clock_id) || 
+		0 != clock_gettime(clock_id, &cpu))
+	{
+		return (0);
+	}
+
+	return (cpu.tv_sec * 1e9 + cpu.tv_nsec);
+}
+
+static void SleepMs(long ms)
+{
+	struct timespec duration;
+
+	duration.tv_sec = ms / 1000;
+	duration.tv_nsec = (ms % 1000) * 1000000;
+	nanosleep(&duration, NULL);
+}
+
+static double RssKb(pid_t pid)
+{
+	char line[LINE_SIZE];
+	char path[PATH_SIZE];
+	double rss_kb = 0;
+	FILE *status = NULL;
+
+	snprintf(path, PATH_SIZE, "/proc/%d/status", (int)pid);
+	status = fopen(path, "r");
+	if (!status)
+	{
+		return (0);
+	}
+
+	while (fgets(line, LINE_SIZE, status))
+	{
+		if (0 == strncmp(line, "VmRSS:", 6))
+		{
+			rss_kb = atof(line + 6);
+		}
+	}
+
+	fclose(status);
+
+	return (rss_kb);
+}
@@ -0,0 +1,122 @@
+/*
+	Name: Guy Feigin
+	Exercise: UID benchmark
+	File Type: Source code
+	Reviewer:
+	Last Updated: Sat 17 Oct 2026 19:03:37
+*/
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* exit() */
+#include <time.h> /* time() */
+#include <unistd.h> /* getpid() */
+#include <pthread.h> /* pthread_create() */
+
+#include "uid.h" /* ilrd_uid_t */
+#include "bench.h" /* BenchReport() */
+
+#define IDS_PER_THREAD (1000000)
+#define MAX_THREADS (64)
+#define NAME_SIZE (64)
+
+typedef ilrd_uid_t (*generate_func_t)(void);
+
+typedef struct generator
+{
+	const char *name;
+	generate_func_t generate;
+} generator_t;
+
+static ilrd_uid_t LockedGenerate(void);
+static void *Generate(void *param);
+static void BenchGenerator(const generator_t *generator, size_t n_threads);
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+int main(int argc, char *argv[])
+{
+	static const generator_t generators[] = {
+		{"atomic", UIDGenerate},
+		{"mutex", LockedGenerate}
+	};
+	size_t n_threads = 0;
+	size_t i = 0;
+
+	BenchInit(argc, argv);
+
+	for (n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2)
+	{
+		for (i = 0; i < sizeof(generators) / sizeof(generators[0]); ++i)
+		{
+			BenchGenerator(&generators[i], n_threads);
+		}
+	}
+
+	return (0);
+}
+
+/* UIDGenerate as it used to be, a global lock and two system calls per id */
+static ilrd_uid_t LockedGenerate(void)
+{
+	ilrd_uid_t uid;
+	static size_t count = 1;
+
+	pthread_mutex_lock(&lock);
+	uid.counter = count++;
+	pthread_mutex_unlock(&lock);
+
+	uid.pid = getpid();
+	uid.time = time(NULL);
+
+	return (uid);
+}
+
+static void *Generate(void *param)
+{
+	generate_func_t generate = *(generate_func_t *)param;
+	size_t sink = 0;
+	size_t i = 0;
+
+	for (i = 0; i < IDS_PER_THREAD; ++i)
+	{
+		sink += generate().counter;
+	}
+
+	return ((void *)sink);
+}
+
+static void BenchGenerator(const generator_t *generator, size_t n_threads)
+{
+	char name[NAME_SIZE];
+	pthread_t threads[MAX_THREADS];
+	generate_func_t generate = generator->generate;
+	size_t start_allocs = 0;
+	double start = 0;
+	size_t i = 0;
+
+	/* The size of the run is the number of threads */
+	snprintf(name, NAME_SIZE, "uid/%s", generator->name);
+	if (!BenchIsSelected(name))
+	{
+		return;
+	}
+
+	start_allocs = BenchAllocs();
+	start = BenchNowNs();
+	for (i = 0; i < n_threads; ++i)
+	{
+		if (0 != pthread_create(&threads[i], NULL, Generate, &generate))
+		{
+			fprintf(stderr, "%s: pthread_create failed\n", generator->name);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	for (i = 0; i < n_threads; ++i)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	BenchReport(name, n_threads, n_threads * IDS_PER_THREAD,
+				BenchNowNs() - start, BenchAllocs() - start_allocs, NULL);
+}
@@ -14,6 +14,7 @@ Last Updated: Feb 20
 
 typedef struct dlist dlist_t;
 typedef struct dlist_node *dlist_iter_t;
+typedef struct dlist_pool dlist_pool_t;
 
 /****************************************************************/
 /* General description: 										*/
@@ -39,6 +40,29 @@ typedef int (*match_func_t)(const void *data, void *param);
 /*              the given parameter   							*/
 typedef int (*action_func_t)(void *data, void *param);
 
+/****************************************************************/
+/* Node pool: nodes are allocated from chunks that grow in 		*/
+/*   size as needed and are recycled through a free list, so a	*/
+/*   list that reached its working size performs no heap calls	*/
+/*   on insert and remove. Every list created with DListCreate	*/
+/*   has a private pool. Lists may also share a pool supplied	*/
+/*   by the caller. A node always returns to the pool it was	*/
+/*   allocated from, also after it was spliced to another list.	*/
+
+/****************************************************************/
+/* Counters of a node pool:										*/
+/*   hits - allocations served from the free list				*/
+/*   misses - allocations that had to grow the pool first		*/
+/*   chunks - number of chunks allocated so far					*/
+/*   free_nodes - nodes currently waiting in the free list		*/
+typedef struct dlist_pool_stats
+{
+	size_t hits;
+	size_t misses;
+	size_t chunks;
+	size_t free_nodes;
+} dlist_pool_stats_t;
+
 /****************************************************************/
 /* Complexity: O(1)												*/
 /* Description:  allocates memory for a doubly linked list		*/
@@ -48,6 +72,49 @@ typedef int (*action_func_t)(void *data, void *param);
 /*               memory allocated for the list					*/
 dlist_t *DListCreate();
 
+/****************************************************************/
+/* Complexity: O(1)												*/
+/* Description:  allocates memory for a doubly linked list that	*/
+/*				 allocates its nodes from the given pool		*/
+/* Arguments:    *pool - pointer to the pool					*/
+/* Return value: returns a pointer to the list					*/
+/* Note: 	     the list keeps a reference to the pool, so the	*/
+/*               caller may destroy the pool right after		*/
+dlist_t *DListCreateWithPool(dlist_pool_t *pool);
+
+/****************************************************************/
+/* Complexity: O(1)												*/
+/* Description:  creates an empty node pool						*/
+/* Arguments:    chunk_nodes - number of nodes in the first		*/
+/*				 chunk, each further chunk is twice as big up	*/
+/*				 to 4096 nodes									*/
+/* Return value: returns a pointer to the pool, NULL on failure	*/
+dlist_pool_t *DListPoolCreate(size_t chunk_nodes);
+
+/****************************************************************/
+/* Complexity: O(chunks)										*/
+/* Description:  releases the caller's reference to the pool.	*/
+/*				 The memory is freed once no list and no node	*/
+/*				 uses the pool anymore							*/
+/* Arguments:    *pool - pointer to the pool					*/
+/* Return value: None											*/
+void DListPoolDestroy(dlist_pool_t *pool);
+
+/****************************************************************/
+/* Complexity: O(1)												*/
+/* Description:  returns the pool the list allocates nodes from	*/
+/* Arguments:    *list - pointer to the list 					*/
+/* Return value: returns a pointer to the pool					*/
+dlist_pool_t *DListGetPool(const dlist_t *list);
+
+/****************************************************************/
+/* Complexity: O(1)												*/
+/* Description:  copies the counters of the pool				*/
+/* Arguments:    *pool - pointer to the pool					*/
+/*				 *stats - where the counters are copied to		*/
+/* Return value: None											*/
+void DListPoolGetStats(const dlist_pool_t *pool, dlist_pool_stats_t *stats);
+
 /****************************************************************/
 /*	Complexity: O(1)											*/
 /* Description:  deallocates memory of a given list				*/
@@ -0,0 +1,73 @@
+/*
+	Name: Guy Feigin
+	Exercise: Histogram
+	File type: Header
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 20:11:52
+*/
+
+#ifndef HIST_H
+#define HIST_H
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+
+/******************************************************************************/
+/* A fixed size log-linear histogram of non negative integers. Every power of */
+/* 2 is split into 8 linear buckets, so a value is kept with a relative error */
+/* of at most 12.5% over the whole 64 bit range, in under 2KB. Recording is a */
+/* few instructions and never allocates.									  */
+
+/******************************************************************************/
+/* type definition for the histogram										  */
+typedef struct hist hist_t;
+
+/******************************************************************************/
+/* Description:  Creates an empty histogram									  */
+/* Arguments:    None														  */
+/* Return value: returns a pointer to the new histogram, NULL on failure	  */
+hist_t *HistCreate(void); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Frees memory of a given histogram							  */
+/* Arguments:    hist - pointer to the histogram							  */
+/* Return value: None														  */
+void HistDestroy(hist_t *hist); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Records a single value										  */
+/* Arguments:    hist - pointer to the histogram							  */
+/*				 value - the value to be recorded							  */
+/* Return value: None														  */
+void HistRecord(hist_t *hist, uint64_t value); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Estimates the value below which the given percentage of the  */
+/*				 recorded values fall. The estimate is the highest value of	  */
+/*				 its bucket, so it never understates the percentile			  */
+/* Arguments:    hist - pointer to the histogram							  */
+/*				 percent - between 0 and 100								  */
+/* Return value: returns the estimate, 0 if nothing was recorded			  */
+uint64_t HistPercentile(const hist_t *hist, double percent); /* O(buckets) */
+
+/******************************************************************************/
+/* Description:  Counts the recorded values									  */
+size_t HistCount(const hist_t *hist); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Returns the exact smallest recorded value, 0 if none		  */
+uint64_t HistMin(const hist_t *hist); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Returns the exact largest recorded value, 0 if none		  */
+uint64_t HistMax(const hist_t *hist); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Returns the mean of the recorded values, 0 if none			  */
+uint64_t HistMean(const hist_t *hist); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Forgets every recorded value								  */
+void HistReset(hist_t *hist); /* O(buckets) */
+
+#endif /* HIST_H */
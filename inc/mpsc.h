@@ -0,0 +1,68 @@
+/*
+	Name: Guy Feigin
+	Exercise: MPSC queue
+	File type: Header
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 15:40:21
+*/
+
+#ifndef MPSC_H
+#define MPSC_H
+
+#include <stdatomic.h> /* _Atomic */
+
+/******************************************************************************/
+/* A lock free, intrusive, multi producer single consumer FIFO queue. Any	  */
+/* number of threads may push concurrently, a push is a single atomic 		  */
+/* exchange. Only one thread at a time may pop. The queue never allocates,	  */
+/* the user embeds an mpsc_node_t in its own element and gets the node back	  */
+/* on pop.																	  */
+
+/******************************************************************************/
+/* type definition for a node of the queue, to be embedded in the element.	  */
+/* Its content is private to the queue.										  */
+typedef struct mpsc_node
+{
+	struct mpsc_node *_Atomic next;
+} mpsc_node_t;
+
+/******************************************************************************/
+/* type definition for the queue											  */
+typedef struct mpsc mpsc_t;
+
+/******************************************************************************/
+/* Description:  Creates an empty queue										  */
+/* Arguments:    None														  */
+/* Return value: returns a pointer to the new queue, NULL on failure		  */
+mpsc_t *MPSCCreate(void); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Frees memory of a given queue. Elements still in the queue	  */
+/*				 are not freed, pop them first								  */
+/* Arguments:    queue - pointer to the queue								  */
+/* Return value: None														  */
+void MPSCDestroy(mpsc_t *queue); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Adds a node to the back of the queue. Safe to call from any  */
+/*				 thread														  */
+/* Arguments:    queue - pointer to the queue								  */
+/*				 node - node embedded in the element, must not be in a queue  */
+/* Return value: None														  */
+void MPSCPush(mpsc_t *queue, mpsc_node_t *node); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Removes the node at the front of the queue. To be called by  */
+/*				 the consumer thread only									  */
+/* Arguments:    queue - pointer to the queue								  */
+/* Return value: returns the node, NULL if the queue is empty. NULL is also	  */
+/*				 returned while a producer is half way through pushing the	  */
+/*				 front node, the node shows up once that push completes		  */
+mpsc_node_t *MPSCPop(mpsc_t *queue); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Checks if the queue is empty. Returns 1 if so, 0 otherwise.  */
+/*				 To be called by the consumer thread only					  */
+int MPSCIsEmpty(const mpsc_t *queue); /* O(1) */
+
+#endif /* MPSC_H */
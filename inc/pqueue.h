@@ -28,16 +28,41 @@ typedef int (*cmp_func_t)(const void *data, const void *param);
 /* to individial needs.														  */
 typedef int (*match_func_t)(const void *data, void *param);
 
+/******************************************************************************/
+/* Called by the heap engine every time an element is placed at a new index,  */
+/* so the user can keep track of where the element is and erase it later with */
+/* PQEraseAt.																  */
+typedef void (*pq_index_func_t)(void *data, size_t index);
+
 /******************************************************************************/
 /* type definition for the priority queue									  */
 typedef struct pq pq_t;
 
+/******************************************************************************/
+/* The engine that backs the priority queue. PQ_SRTLIST keeps the elements in */
+/* a sorted linked list (O(n) enqueue, O(1) dequeue). PQ_HEAP keeps them in a */
+/* contiguous 4-ary heap (O(log n) enqueue and dequeue, no allocation per 	  */
+/* element). Both engines dequeue elements of equal priority in FIFO order.	  */
+typedef enum pq_type
+{
+	PQ_SRTLIST = 0,
+	PQ_HEAP
+} pq_type_t;
+
 /******************************************************************************/
 /* Description:  Creates an empty priority list								  */
 /* Arguments:    receives a compare function that's used to define priority	  */
 /* Return value: returns a pointer to the newly created priority queue		  */
+/* Note:         the queue is backed by the sorted list engine				  */
 pq_t *PQCreate(cmp_func_t cmp_func); /* O(1) */
 
+/******************************************************************************/
+/* Description:  Creates an empty priority list backed by the given engine	  */
+/* Arguments:    cmp_func - compare function that's used to define priority	  */
+/*				 type - the engine to use, PQ_SRTLIST or PQ_HEAP			  */
+/* Return value: returns a pointer to the newly created priority queue		  */
+pq_t *PQCreateType(cmp_func_t cmp_func, pq_type_t type); /* O(1) */
+
 /******************************************************************************/
 /* Description:  Frees memory of a given priority queue 					  */
 /* Arguments: 	 receives a pointer to the priority queue to be freed		  */
@@ -50,7 +75,7 @@ void PQDestroy(pq_t *pq); /* O(n) */
 /* Arguments: 	 receives a pointer to an existing priority queue and a 	  */
 /*				 pointer to the data to be inserted into the queue			  */
 /* Return value: returns 0 if successful, 1 otherwise						  */
-int PQEnqueue(pq_t *pq, void *data); /* O(n) */
+int PQEnqueue(pq_t *pq, void *data); /* O(n), heap: O(log n) */
 
 /******************************************************************************/
 /* Description:  Removes an element from the queue with the highest priority  */
@@ -58,7 +83,7 @@ int PQEnqueue(pq_t *pq, void *data); /* O(n) */
 /* Return value: returns a void pointer to the data removed					  */
 /* Note:         Attempting to remove from an empty list will result in 	  */
 /*				 undefined behavior 										  */
-void *PQDequeue(pq_t *pq); /* O(1) */
+void *PQDequeue(pq_t *pq); /* O(1), heap: O(log n) */
 
 /******************************************************************************/
 /* Description:  Returns the element with the highest priority in the queue	  */
@@ -77,7 +102,7 @@ int PQIsEmpty(const pq_t *pq); /* O(1) */
 /* Description:  Counts the number of elements in the queue					  */
 /* Arguments: 	 receives a pointer to a priority queue						  */
 /* Return value: returns the number of elements in the queue as size_t		  */
-size_t PQCount(const pq_t *pq); /* O(n) */
+size_t PQCount(const pq_t *pq); /* O(n), heap: O(1) */
 
 /******************************************************************************/
 /* Description:  Removes a given element from the queue. The user must define */
@@ -88,12 +113,31 @@ size_t PQCount(const pq_t *pq); /* O(n) */
 /* Return value: returns a void pointer to the erased element				  */
 void *PQErase(pq_t *pq, match_func_t match_func, void *param); /* O(n) */
 
+/******************************************************************************/
+/* Description:  Registers a function that is told the index of an element   */
+/*				 every time it moves inside the heap. It's called right away  */
+/*				 for the elements that are already in the queue				  */
+/* Arguments: 	 receives a pointer to a heap priority queue and the index	  */
+/*				 function, or NULL to stop tracking							  */
+/* Return value: None														  */
+/* Note:         only the PQ_HEAP engine supports indices					  */
+void PQSetIndexFunc(pq_t *pq, pq_index_func_t index_func); /* O(n) */
+
+/******************************************************************************/
+/* Description:  Removes the element at the given index of the heap			  */
+/* Arguments: 	 receives a pointer to a heap priority queue and the index 	  */
+/*				 last reported for the element by the index function		  */
+/* Return value: returns a void pointer to the erased element				  */
+/* Note:         only the PQ_HEAP engine supports indices, an index that is	  */
+/*				 out of range will result in undefined behavior				  */
+void *PQEraseAt(pq_t *pq, size_t index); /* O(log n) */
+
 /******************************************************************************/
 /* Description:  Clears the entire priority queue from elements without 	  */
 /*				 destroying it												  */
 /* Arguments: 	 receives a pointer to a priority queue						  */
 /* Return value: returns a pointer to the cleared priority queue			  */
-void PQClear(pq_t *pq); /* O(n) */
+void PQClear(pq_t *pq); /* O(n), heap: O(1) */
 
 #endif /* P_Q */
 
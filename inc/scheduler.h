@@ -9,8 +9,25 @@
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
+#include <stddef.h> /* size_t */
+
 #include "uid.h" /* ilrd_uid_t */
 
+/******************************************************************************/
+/*
+	--Threads:
+	
+	A scheduler is owned by the thread that created it, and while SchedRun 
+	is running, by the thread that runs it. SchedAddTask, SchedAddTaskMs, 
+	SchedAddTaskNs, SchedRemoveTask and SchedStop may be called from any 
+	thread. When called from a thread that doesn't own the scheduler, the 
+	request is posted to a lock free submission queue and applied by the 
+	owner, in the order it was posted, the next time the run loop wakes up 
+	or the owner calls one of the functions above. All other functions must 
+	be called by the owner only.
+*/
+/******************************************************************************/
+
 /******************************************************************************/
 /*
 	--Description:
@@ -66,6 +83,30 @@ typedef struct scheduler scheduler_t;
 typedef void (*cleanup_func_t)(void* param);
 /******************************************************************************/
 
+/******************************************************************************/
+/*
+	--Description:
+	
+	Defines a function pointer type fd_action_func_t for the action function 
+	associated with a watched fd.
+
+	--Signature:
+
+    int function_name(int fd, void* param)
+
+	--Arguments:
+
+    fd: The fd that became readable.
+    param: A pointer to any parameters needed by the action function.
+
+	--Return Value:
+
+    Same as action_func_t. REPEAT keeps the fd watched, any other value 
+    stops watching it, and STOP or ERROR also end the run.
+*/
+typedef int (*fd_action_func_t)(int fd, void* param);
+/******************************************************************************/
+
 /******************************************************************************/
 /*
 	--Description:
@@ -79,16 +120,83 @@ typedef void (*cleanup_func_t)(void* param);
     SUCCESS: Indicates successful execution with a value of 0.
     STOP: Indicates stopping or termination with a value of 1.
     REPEAT: Indicates that a task requests to be repeated with a value of 2.
+    QUEUED: Indicates that a request was posted to the owner, but not yet 
+    		applied, with a value of 3. Not to be returned by tasks.
 */
 enum 
 {
     ERROR = -1,
     SUCCESS,
     STOP,
-    REPEAT
+    REPEAT,
+    QUEUED
+};
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Defines the levels of instrumentation of a scheduler.
+
+	--Values:
+
+    SCHED_STATS_OFF: Nothing is recorded, the default.
+    SCHED_STATS_AGGREGATE: Lateness, duration and queue depth are recorded 
+    					   for the scheduler as a whole.
+    SCHED_STATS_PER_TASK: On top of that, lateness and duration are recorded 
+    					  for every task separately.
+*/
+enum 
+{
+    SCHED_STATS_OFF,
+    SCHED_STATS_AGGREGATE,
+    SCHED_STATS_PER_TASK
 };
 /******************************************************************************/
 
+/******************************************************************************/
+/*
+	--Description:
+	
+	Defines a summary of one recorded quantity. The count, min, max and 
+	mean are exact. The percentiles are estimated from a log-linear 
+	histogram and are at most 12.5% above the true value.
+*/
+typedef struct sched_summary
+{
+    size_t count;
+    size_t min;
+    size_t max;
+    size_t mean;
+    size_t p50;
+    size_t p90;
+    size_t p99;
+    size_t p999;
+} sched_summary_t;
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Defines the stats of a scheduler or of a single task.
+
+	--Fields:
+
+    lateness_ns: How long after its deadline a task started to run.
+    duration_ns: How long the action of a task ran.
+    queue_depth: How many tasks were waiting or running whenever a task was 
+    			 about to run. Always empty for a single task.
+*/
+typedef struct sched_stats
+{
+    sched_summary_t lateness_ns;
+    sched_summary_t duration_ns;
+    sched_summary_t queue_depth;
+} sched_stats_t;
+/******************************************************************************/
+
 /******************************************************************************/
 /*
 	--Description:
@@ -111,6 +219,120 @@ enum
 scheduler_t *SchedCreate(void); /* O(1) */
 /******************************************************************************/
 
+/******************************************************************************/
+/*
+	--Description:
+	
+	Creates a new scheduler that keeps its tasks in a hierarchical timing 
+	wheel instead of a priority queue. Adding, removing and expiring a task 
+	are O(1), which pays off with very large numbers of periodic tasks. 
+	Tasks that become due on the same tick run in the order they were added.
+
+	--Arguments:
+
+    None.
+
+	--Return Value:
+
+    Returns a pointer to the created scheduler on success.
+    Returns NULL if memory allocation fails.
+
+	Undefined Behavior:
+
+    None.
+*/
+scheduler_t *SchedCreateWheel(void); /* O(1) */
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Sets the number of worker threads that run the tasks of the scheduler. 
+	With workers, SchedRun hands every due task to a pool of threads, each 
+	with its own deque of tasks and stealing from the others when it runs 
+	dry, so a slow task doesn't delay the other due tasks. A task that 
+	returns REPEAT is scheduled again once it comes back from its worker, 
+	so the same task never runs twice at the same time. Tasks run 
+	concurrently with each other, and a task running on a worker calls the 
+	scheduler as a thread that doesn't own it. With 0 workers, which is the 
+	default, tasks run one by one on the thread that calls SchedRun.
+
+	--Arguments:
+
+    sched: Pointer to the scheduler.
+    n_workers: Number of worker threads, 0 to run the tasks inline.
+
+	--Return Value:
+
+    Returns SUCCESS on success.
+    Returns ERROR if the threads could not be created, in which case the 
+    previous setting is kept.
+
+	--Undefined Behavior:
+
+    If sched is NULL or the scheduler is running, the behavior is undefined.
+*/
+int SchedSetWorkers(scheduler_t *sched, size_t n_workers); /* O(n_workers) */
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Watches an fd for being readable. The run loop waits on it along with 
+	the deadline of the next task, and runs the action on the thread that 
+	runs the scheduler as soon as the fd becomes readable, e.g. a pidfd 
+	the moment its process exits. The fd stays owned by the caller, and the 
+	action keeps being run for as long as the fd is readable, so it should 
+	consume what made it readable or stop watching it. Watching an fd that 
+	is already watched replaces its action.
+
+	--Arguments:
+
+    sched: Pointer to the scheduler.
+    fd: The fd to watch.
+    action: The action to run when the fd becomes readable.
+    param: Parameter passed to the action.
+
+	--Return Value:
+
+    Returns SUCCESS on success.
+    Returns ERROR if the fd can't be watched, or if the scheduler has no 
+    event fds and runs by sleeping.
+
+	--Undefined Behavior:
+
+    If sched or action is NULL, or fd is negative, the behavior is undefined.
+*/
+int SchedWatchFd(scheduler_t *sched, int fd, fd_action_func_t action, 
+				 void *param); /* O(1) amortized */
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Stops watching an fd. To be called before the fd is closed, or right 
+	after, but before its number can be reused.
+
+	--Arguments:
+
+    sched: Pointer to the scheduler.
+    fd: The watched fd.
+
+	--Return Value:
+
+    Returns SUCCESS on success.
+    Returns ERROR if the fd isn't watched.
+
+	--Undefined Behavior:
+
+    If sched is NULL, the behavior is undefined.
+*/
+int SchedUnwatchFd(scheduler_t *sched, int fd); /* O(1) */
+/******************************************************************************/
+
 /******************************************************************************/
 /*
 	--Description:
@@ -153,6 +375,8 @@ void SchedDestroy(scheduler_t *sched); /* O(n) */
 
     Returns the UID of the added task on success.
     Returns bad_uid if memory allocation fails.
+    When called from a thread that doesn't own the scheduler, the UID is 
+    returned right away and the task is scheduled once the owner applies it.
 
 	--Undefined Behavior:
 
@@ -163,7 +387,67 @@ ilrd_uid_t SchedAddTask(scheduler_t *sched,
 						action_func_t action, 
 						void *action_param, 
 						cleanup_func_t cleanup_func, 
-						void *cleanup_param);  /* O(n) */ 
+						void *cleanup_param);  /* O(log n) */ 
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Adds a new task to the scheduler, with an interval given in milliseconds.
+
+	--Arguments:
+
+    Same as SchedAddTask, except for:
+    interval_ms: Time interval (in milliseconds) after which the task should 
+    			 be executed again.
+
+	--Return Value:
+
+    Returns the UID of the added task on success.
+    Returns bad_uid if memory allocation fails.
+
+	--Undefined Behavior:
+
+    If sched or action is NULL, the behavior is undefined.
+*/
+ilrd_uid_t SchedAddTaskMs(scheduler_t *sched, 
+						  size_t interval_ms, 
+						  action_func_t action, 
+						  void *action_param, 
+						  cleanup_func_t cleanup_func, 
+						  void *cleanup_param);  /* O(log n) */ 
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Adds a new task to the scheduler, with an interval given in nanoseconds.
+	Deadlines are kept on the monotonic clock, so the task is not affected 
+	by changes of the wall clock.
+
+	--Arguments:
+
+    Same as SchedAddTask, except for:
+    interval_ns: Time interval (in nanoseconds) after which the task should 
+    			 be executed again.
+
+	--Return Value:
+
+    Returns the UID of the added task on success.
+    Returns bad_uid if memory allocation fails.
+
+	--Undefined Behavior:
+
+    If sched or action is NULL, the behavior is undefined.
+*/
+ilrd_uid_t SchedAddTaskNs(scheduler_t *sched, 
+						  size_t interval_ns, 
+						  action_func_t action, 
+						  void *action_param, 
+						  cleanup_func_t cleanup_func, 
+						  void *cleanup_param);  /* O(log n) */ 
 /******************************************************************************/
 
 /******************************************************************************/		
@@ -181,19 +465,27 @@ ilrd_uid_t SchedAddTask(scheduler_t *sched,
 
     Returns SUCCESS if the task is successfully removed.
     Returns ERROR if the task is not found.
+    When called from a thread that doesn't own the scheduler, returns QUEUED 
+    once the removal is posted, and ERROR if posting it failed. Whether the 
+    task existed isn't known then, a task that is not found by the time the 
+    removal is applied is left alone.
 
 	--Undefined Behavior:
 
     If sched is NULL, the behavior is undefined.
 */				
-int SchedRemoveTask(scheduler_t *sched, ilrd_uid_t task_id);  /* O(n) */
+int SchedRemoveTask(scheduler_t *sched, ilrd_uid_t task_id);  /* O(log n) */
 /******************************************************************************/
 
 /******************************************************************************/
 /*
 	--Description:
 	
-	Starts running the tasks in the scheduler.
+	Starts running the tasks in the scheduler. Between tasks the scheduler 
+	waits on a timerfd armed to the exact deadline of the next task, and is 
+	woken up early when a task is added or removed or the scheduler is 
+	stopped. A scheduler created 
+	with SchedCreateWheel runs its tasks with a resolution of one millisecond.
 
 	--Arguments:
 
@@ -206,6 +498,8 @@ int SchedRemoveTask(scheduler_t *sched, ilrd_uid_t task_id);  /* O(n) */
     Returns REPEAT if a task requests to be repeated.
     Returns ERROR if an error occurs during execution.
     Returns STOP if the stop function is sent to the scheduler.
+    With workers, returns the status of the first task that ended the run, 
+    after every task that was still running on a worker has come back.
 
 	--Undefined Behavior:
 
@@ -218,7 +512,9 @@ int SchedRun(scheduler_t *sched);  /* O(n) */
 /*
 	--Description:
 	
-	Stops the execution of the scheduler.
+	Stops the execution of the scheduler. A run loop that is waiting for its 
+	next task is woken up right away, so SchedRun returns without waiting 
+	for the next deadline.
 
 	--Arguments:
 
@@ -299,4 +595,102 @@ size_t SchedSize(const scheduler_t *sched);  /* O(1) */
 int SchedIsEmpty(const scheduler_t *sched);  /* O(1) */ 
 /******************************************************************************/
 
+/******************************************************************************/
+/*
+	--Description:
+	
+	Sets the level of instrumentation of the scheduler. While it's off, 
+	running a task costs a single extra branch. While it's on, every run 
+	reads the monotonic clock twice and is recorded in fixed size 
+	histograms. Raising the level keeps what was recorded so far, turning 
+	it off or lowering it to SCHED_STATS_AGGREGATE drops the stats that 
+	are no longer kept.
+
+	--Arguments:
+
+    sched: Pointer to the scheduler.
+    level: SCHED_STATS_OFF, SCHED_STATS_AGGREGATE or SCHED_STATS_PER_TASK.
+
+	--Return Value:
+
+    Returns SUCCESS on success.
+    Returns ERROR if memory allocation fails.
+
+	--Undefined Behavior:
+
+    If sched is NULL or the scheduler is running, the behavior is undefined.
+*/
+int SchedEnableStats(scheduler_t *sched, int level);  /* O(n) */
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Gets the stats recorded for the scheduler as a whole.
+
+	--Arguments:
+
+    sched: Pointer to the scheduler.
+    stats: Pointer to the stats to be filled.
+
+	--Return Value:
+
+    Returns SUCCESS on success.
+    Returns ERROR if stats are not enabled.
+
+	--Undefined Behavior:
+
+    If sched or stats is NULL, the behavior is undefined.
+*/
+int SchedGetStats(const scheduler_t *sched, sched_stats_t *stats);  /* O(1) */
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Gets the stats recorded for a single task. A task's stats go away 
+	along with the task.
+
+	--Arguments:
+
+    sched: Pointer to the scheduler.
+    task_id: UID of the task.
+    stats: Pointer to the stats to be filled.
+
+	--Return Value:
+
+    Returns SUCCESS on success.
+    Returns ERROR if per task stats are not enabled or the task is not found.
+
+	--Undefined Behavior:
+
+    If sched or stats is NULL, the behavior is undefined.
+*/
+int SchedGetTaskStats(const scheduler_t *sched, ilrd_uid_t task_id, 
+					  sched_stats_t *stats);  /* O(1) */
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Forgets everything recorded so far, the level of instrumentation stays.
+
+	--Arguments:
+
+    sched: Pointer to the scheduler.
+
+	--Return Value:
+
+    None.
+
+	--Undefined Behavior:
+
+    If sched is NULL or the scheduler is running, the behavior is undefined.
+*/
+void SchedResetStats(scheduler_t *sched);  /* O(n) */
+/******************************************************************************/
+
 #endif /*SCHEDULER_H*/
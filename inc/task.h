@@ -100,6 +100,41 @@ task_t *TaskCreate(size_t interval,
 				   void *cleanup_params); 
 /******************************************************************************/
 
+/******************************************************************************/
+/*
+	--Description:
+	
+	Creates a new task for the scheduler, with an interval given in 
+	nanoseconds. The first deadline is the interval from now on the 
+	monotonic clock.
+
+	--Arguments:
+
+    interval_ns: Time interval (in nanoseconds) after which the task should 
+    			 be executed again.
+    action:   Pointer to the function that performs the task's action.
+    cleanup:  Pointer to the cleanup function that should be called when the 
+    		  task is destroyed.
+    action_params: Pointer to any parameters needed by the action function.
+    cleanup_params: Pointer to any parameters needed by the cleanup function.
+
+	--Return Value:
+
+    Returns a pointer to the created task on success.
+    Returns NULL if memory allocation fails or if the UID generation fails.
+
+	--Undefined Behavior:
+
+    If the action function pointer (action) is NULL, the behavior is 
+    undefined.
+*/
+task_t *TaskCreateNs(size_t interval_ns, 
+					 task_action_func_t action, 
+					 task_clean_func_t cleanup, 
+					 void *action_params, 
+					 void *cleanup_params); 
+/******************************************************************************/
+
 /******************************************************************************/
 /*
 	--Description:
@@ -200,8 +235,8 @@ int TaskIsSame(const task_t *task1, const task_t *task2);
 
 	--Return Value:
 
-    Returns the time (in seconds since the epoch) when the task is scheduled to 
-    run next.
+    Returns the second on the monotonic clock (CLOCK_MONOTONIC) at which the 
+    task is scheduled to run next. Use TaskGetDeadline for the exact time.
 
 	--Undefined Behavior:
 
@@ -210,12 +245,37 @@ int TaskIsSame(const task_t *task1, const task_t *task2);
 time_t TaskGetTimeToRun(const task_t *task);
 /******************************************************************************/
 
+/******************************************************************************/
+/*
+	--Description:
+	
+	Gets the exact time at which the given task is scheduled to run next.
+
+	--Arguments:
+
+    task: Pointer to the task.
+
+	--Return Value:
+
+    Returns the deadline of the task on the monotonic clock (CLOCK_MONOTONIC), 
+    with nanosecond resolution.
+
+	--Undefined Behavior:
+
+    If task is NULL, the behavior is undefined.
+*/
+struct timespec TaskGetDeadline(const task_t *task);
+/******************************************************************************/
+
 /******************************************************************************/
 /*
 	--Description:
 	
 	Updates the time at which the given task is scheduled to run next based on 
-	its interval.
+	its interval. The deadline moves forward by exactly one interval, so a 
+	periodic task doesn't drift. If that deadline has already passed, the 
+	missed periods are skipped and the task is scheduled one interval from 
+	now.
 
 	--Arguments:
 
@@ -232,6 +292,138 @@ time_t TaskGetTimeToRun(const task_t *task);
 void TaskUpdateTimeToRun(task_t *task);
 /******************************************************************************/
 
+/******************************************************************************/
+/*
+	--Description:
+	
+	Stores the index of the task inside the heap that currently holds it, 
+	so the scheduler can remove the task without searching for it.
+
+	--Arguments:
+
+    task: Pointer to the task.
+    index: The index reported by the heap.
+
+	--Return Value:
+
+    None.
+
+	--Undefined Behavior:
+
+    If task is NULL, the behavior is undefined.
+*/
+void TaskSetQueueIndex(task_t *task, size_t index);
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Gets the index last stored with TaskSetQueueIndex.
+
+	--Arguments:
+
+    task: Pointer to the task.
+
+	--Return Value:
+
+    Returns the index of the task inside its heap.
+
+	--Undefined Behavior:
+
+    If task is NULL, the behavior is undefined.
+*/
+size_t TaskGetQueueIndex(const task_t *task);
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Stores the handle of the task inside the timing wheel that currently 
+	holds it, so the scheduler can remove the task without searching for it.
+
+	--Arguments:
+
+    task: Pointer to the task.
+    handle: The handle returned by the timing wheel.
+
+	--Return Value:
+
+    None.
+
+	--Undefined Behavior:
+
+    If task is NULL, the behavior is undefined.
+*/
+void TaskSetQueueHandle(task_t *task, void *handle);
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Gets the handle last stored with TaskSetQueueHandle.
+
+	--Arguments:
+
+    task: Pointer to the task.
+
+	--Return Value:
+
+    Returns the handle of the task inside its timing wheel.
+
+	--Undefined Behavior:
+
+    If task is NULL, the behavior is undefined.
+*/
+void *TaskGetQueueHandle(const task_t *task);
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Marks the task as handed over to a worker thread. While it's in flight 
+	the task is not in any queue and only the worker may run it.
+
+	--Arguments:
+
+    task: Pointer to the task.
+    in_flight: 1 when the task is handed to a worker, 0 when it comes back.
+
+	--Return Value:
+
+    None.
+
+	--Undefined Behavior:
+
+    If task is NULL, the behavior is undefined.
+*/
+void TaskSetInFlight(task_t *task, int in_flight);
+/******************************************************************************/
+
+/******************************************************************************/
+/*
+	--Description:
+	
+	Checks if the task is in flight, as last set with TaskSetInFlight.
+
+	--Arguments:
+
+    task: Pointer to the task.
+
+	--Return Value:
+
+    Returns 1 if the task is in flight, 0 otherwise.
+
+	--Undefined Behavior:
+
+    If task is NULL, the behavior is undefined.
+*/
+int TaskIsInFlight(const task_t *task);
+/******************************************************************************/
+
 #endif /*TASK_H*/
 
 
@@ -0,0 +1,134 @@
+/*
+	Name: Guy Feigin
+	Exercise: Timing wheel
+	File type: Header
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 10:12:04
+*/
+
+#ifndef TWHEEL_H
+#define TWHEEL_H
+
+#include <stddef.h> /* size_t */
+
+/******************************************************************************/
+/* A hashed hierarchical timing wheel. Every element has an expiry tick and   */
+/* is kept in one of 4 levels of 64 slots each, where level l holds elements  */
+/* that expire within 64^(l+1) ticks. As time advances, the slots of the 	  */
+/* upper levels are cascaded down, and the elements whose tick has come are   */
+/* moved to an expired list in expiry order. Insert, remove by handle and 	  */
+/* expire are all O(1).														  */
+
+/******************************************************************************/
+/* Description:  Returns the tick at which the given element expires. To be	  */
+/*				 defined by the user. It's called on insertion and whenever	  */
+/*				 the element is cascaded, so it must stay the same while the  */
+/*				 element is inside the wheel.								  */
+typedef size_t (*tw_key_func_t)(const void *data);
+
+/******************************************************************************/
+/* Description:  Used by TWErase to find the element to be erased. Returns 1  */
+/*				 if data matches param, 0 otherwise							  */
+typedef int (*tw_match_func_t)(const void *data, void *param);
+
+/******************************************************************************/
+/* Description:  Used by TWForEach to perform an action on every element.	  */
+/*				 Returns 0 on success, non zero to stop the iteration		  */
+typedef int (*tw_action_func_t)(void *data, void *param);
+
+/******************************************************************************/
+/* type definition for the timing wheel and for a handle to one of its 		  */
+/* elements. A handle stays valid until the element is removed or popped.	  */
+typedef struct twheel twheel_t;
+typedef struct dlist_node *tw_handle_t;
+
+/******************************************************************************/
+/* Description:  Creates an empty timing wheel								  */
+/* Arguments:    key_func - returns the expiry tick of an element			  */
+/*				 now - the current tick										  */
+/* Return value: returns a pointer to the new timing wheel, NULL on failure   */
+twheel_t *TWCreate(tw_key_func_t key_func, size_t now); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Frees memory of a given timing wheel. The elements		  	  */
+/*				 themselves are not freed									  */
+/* Arguments:    tw - pointer to the timing wheel							  */
+/* Return value: None														  */
+void TWDestroy(twheel_t *tw); /* O(n) */
+
+/******************************************************************************/
+/* Description:  Adds an element to the wheel. An element whose tick has 	  */
+/*				 already passed goes straight to the expired list			  */
+/* Arguments:    tw - pointer to the timing wheel							  */
+/*				 data - the element to be inserted							  */
+/* Return value: returns a handle to the element, NULL on failure			  */
+tw_handle_t TWInsert(twheel_t *tw, void *data); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Removes the element the handle refers to					  */
+/* Arguments:    tw - pointer to the timing wheel							  */
+/*				 handle - handle returned by TWInsert						  */
+/* Return value: returns the removed element								  */
+void *TWRemove(twheel_t *tw, tw_handle_t handle); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Removes the first element that matches param				  */
+/* Arguments:    tw - pointer to the timing wheel							  */
+/*				 match_func - returns 1 if data matches param, 0 otherwise	  */
+/*				 param - parameter to be sent to the match function			  */
+/* Return value: returns the removed element, NULL if none matched			  */
+void *TWErase(twheel_t *tw, tw_match_func_t match_func, void *param); /* O(n) */
+
+/******************************************************************************/
+/* Description:  Moves the wheel forward to the given tick, cascading the 	  */
+/*				 upper levels and expiring every element whose tick is not	  */
+/*				 after now													  */
+/* Arguments:    tw - pointer to the timing wheel							  */
+/*				 now - the current tick. Going backwards has no effect		  */
+/* Return value: None														  */
+void TWAdvance(twheel_t *tw, size_t now); /* O(ticks passed) */
+
+/******************************************************************************/
+/* Description:  Removes the earliest expired element						  */
+/* Arguments:    tw - pointer to the timing wheel							  */
+/* Return value: returns the element, NULL if nothing has expired			  */
+void *TWPopExpired(twheel_t *tw); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Returns the next tick at which the wheel has work to do:	  */
+/*				 either an element expires or a slot has to be cascaded.	  */
+/*				 Advancing to it and checking the expired list again is 	  */
+/*				 enough to never miss an expiry								  */
+/* Arguments:    tw - pointer to the timing wheel							  */
+/* Return value: returns the current tick if something already expired, 	  */
+/*				 (size_t)-1 if the wheel is empty							  */
+size_t TWNextTick(const twheel_t *tw); /* O(slots) */
+
+/******************************************************************************/
+/* Description:  Returns the tick the wheel was last advanced to			  */
+size_t TWNow(const twheel_t *tw); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Counts the elements in the wheel, expired ones included	  */
+size_t TWCount(const twheel_t *tw); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Checks if the wheel is empty. Returns 1 if so, 0 otherwise   */
+int TWIsEmpty(const twheel_t *tw); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Performs an action on every element in the wheel			  */
+/* Arguments:    tw - pointer to the timing wheel							  */
+/*				 action - function called with each element and param		  */
+/*				 param - parameter to be sent to the action function		  */
+/* Return value: returns 0 if all actions succeeded, otherwise the status of  */
+/*				 the action that failed										  */
+int TWForEach(twheel_t *tw, tw_action_func_t action, void *param); /* O(n) */
+
+/******************************************************************************/
+/* Description:  Removes every element from the wheel without freeing them	  */
+/* Arguments:    tw - pointer to the timing wheel							  */
+/* Return value: None														  */
+void TWClear(twheel_t *tw); /* O(n) */
+
+#endif /* TWHEEL_H */
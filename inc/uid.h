@@ -4,6 +4,7 @@
 #include <stddef.h> /*size_t*/
 #include <sys/types.h> /*pid_t*/
 #include <time.h> /*time_t*/
+#include <stdint.h> /*uint64_t*/
 
 /******************************************************************************/
 /* Each unique id will have the following structure to help identify it and   */
@@ -30,12 +31,31 @@ extern const ilrd_uid_t bad_uid;
 /* Arguments:    None														  */
 /* Return value: returns an instance of a uid struct                          */
 /* Note: 		 if the uid generation fails it will return a bad_uid instance*/
+/* Note: 		 safe to call from any thread, it takes no lock. The pid is  */
+/*				 read once per process and refreshed in the child of a fork	  */
 ilrd_uid_t UIDGenerate(void);
 
+/******************************************************************************/
+/* Description:  packs a uid into 64 bits, the pid in the upper 22 bits and   */
+/*				 the lower 42 bits of the counter below it. The compact form  */
+/*				 tells apart the uids generated by all the processes that are */
+/*				 alive on the host, but not uids of processes that have 	  */
+/*				 exited and whose pid was reused							  */
+/* Arguments:    receives the uid struct to be packed						  */
+/* Return value: returns the compact uid									  */
+uint64_t UIDCompact(ilrd_uid_t uid);
+
 /******************************************************************************/
 /* Description:  checks if two uid structs are identical					  */
 /* Arguments:    receives two uid structs to be compared 					  */
 /* Return value: returns 1 if the uid structs are identical, 0 otherwise.     */
 int UIDIsEqual(ilrd_uid_t one, ilrd_uid_t other);
 
+/******************************************************************************/
+/* Description:  hashes a uid struct, all of its members take part in the 	  */
+/*				 hash so uids of different processes spread as well			  */
+/* Arguments:    receives the uid struct to be hashed						  */
+/* Return value: returns the hash value										  */
+size_t UIDHash(ilrd_uid_t uid);
+
 #endif /*ILRD_UID_H*/
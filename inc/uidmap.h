@@ -0,0 +1,86 @@
+/*
+	Name: Guy Feigin
+	Exercise: UID map
+	File type: Header
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 13:05:47
+*/
+
+#ifndef UIDMAP_H
+#define UIDMAP_H
+
+#include <stddef.h> /* size_t */
+
+#include "uid.h" /* ilrd_uid_t */
+
+/******************************************************************************/
+/* A hash map from a uid to a value, kept in a single array with open 		  */
+/* addressing and linear probing. Removal shifts the following entries back,  */
+/* so lookups never have to skip deleted entries. The map doubles its 		  */
+/* capacity when it's 70% full.												  */
+
+/******************************************************************************/
+/* Description:  Used by UIDMapForEach to perform an action on every value.   */
+/*				 Returns 0 on success, non zero to stop the iteration. It	  */
+/*				 must not insert into or remove from the map				  */
+typedef int (*uidmap_action_func_t)(void *value, void *param);
+
+/******************************************************************************/
+/* type definition for the uid map											  */
+typedef struct uidmap uidmap_t;
+
+/******************************************************************************/
+/* Description:  Creates an empty map										  */
+/* Arguments:    capacity - expected number of entries, 0 for a default 	  */
+/* Return value: returns a pointer to the new map, NULL on failure			  */
+uidmap_t *UIDMapCreate(size_t capacity); /* O(capacity) */
+
+/******************************************************************************/
+/* Description:  Frees memory of a given map. The values are not freed		  */
+/* Arguments:    map - pointer to the map									  */
+/* Return value: None														  */
+void UIDMapDestroy(uidmap_t *map); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Maps the uid to the value									  */
+/* Arguments:    map - pointer to the map									  */
+/*				 uid - the key, must not be in the map already				  */
+/*				 value - the value, must not be NULL						  */
+/* Return value: returns 0 on success, 1 if the map failed to grow			  */
+int UIDMapInsert(uidmap_t *map, ilrd_uid_t uid, void *value); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Looks up the value mapped to the uid						  */
+/* Arguments:    map - pointer to the map									  */
+/*				 uid - the key to look for									  */
+/* Return value: returns the value, NULL if the uid is not in the map		  */
+void *UIDMapFind(const uidmap_t *map, ilrd_uid_t uid); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Removes the uid from the map								  */
+/* Arguments:    map - pointer to the map									  */
+/*				 uid - the key to be removed								  */
+/* Return value: returns the value that was mapped, NULL if the uid is not in */
+/*				 the map													  */
+void *UIDMapRemove(uidmap_t *map, ilrd_uid_t uid); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Counts the entries in the map								  */
+size_t UIDMapCount(const uidmap_t *map); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Removes all the entries from the map						  */
+void UIDMapClear(uidmap_t *map); /* O(capacity) */
+
+/******************************************************************************/
+/* Description:  Performs an action on every value in the map, in no 		  */
+/*				 particular order											  */
+/* Arguments:    map - pointer to the map									  */
+/*				 action - function called with each value and param			  */
+/*				 param - parameter to be sent to the action function		  */
+/* Return value: returns 0 if all actions succeeded, otherwise the status of  */
+/*				 the action that failed										  */
+int UIDMapForEach(const uidmap_t *map, uidmap_action_func_t action, 
+				  void *param); /* O(capacity) */
+
+#endif /* UIDMAP_H */
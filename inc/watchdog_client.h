@@ -1,12 +1,81 @@
 #ifndef __ILRD_WD_1556__
 #define __ILRD_WD_1556__
 
+#include "wd_shm.h" /* wd_incident_t */
+
+/* How many listening sockets the pair may keep, see WDRegisterListenFds */
+#define WD_LISTEN_MAX (16)
+
 typedef enum wd_status
 {
     WD_SUCCESS = 0,
     WD_FAILURE
 } wd_status_t;
 
+/*
+Description:
+    -Where the watchdog of the process stands, see WDGetState
+Values:
+    -WD_STATE_OFF: WDStart wasn't called, or WDStop was
+    -WD_STATE_ACTIVE: the process is protected
+    -WD_STATE_BACKOFF: the watchdog process died again too soon, and is
+     revived only once a delay is over
+    -WD_STATE_GAVE_UP: the watchdog process died more often than its
+     restart budget allows, and isn't revived anymore. The process runs on
+     unprotected
+*/
+typedef enum wd_state
+{
+    WD_STATE_OFF = 0,
+    WD_STATE_ACTIVE,
+    WD_STATE_BACKOFF,
+    WD_STATE_GAVE_UP
+} wd_state_t;
+
+/*
+Description:
+    -Timing of a watchdog pair, all in milliseconds
+Fields:
+    -heartbeat_ms: how often each side beats and checks the other side
+    -miss_threshold: how many beats in a row may be missed before the other
+     side is declared hung and revived, at the latest
+    -stop_poll_ms: how often the watchdog checks if WDStop was called, which
+     is about how long WDStop blocks
+    -warm_standby: non 0 to have the watchdog keep a standby instance of the
+     process, see WDStartEx
+    -restart_budget: how many times each side may be revived within
+     restart_window_ms. Past that, the other side gives up on it
+    -restart_window_ms: the window the budget is counted in, it starts at
+     the first revive
+    -backoff_ms: the first revive of a window is immediate, the next one
+     waits backoff_ms, and every one after it twice as long as the last
+    -backoff_max_ms: the longest a revive may wait
+    -false_positive_ppm: how often in a million checks the other side may
+     be declared hung while its beat is only late. Each side learns how
+     much the beats of the other one jitter, and declares it hung as soon as
+     a beat is this unlikely to still come, see wd_phi.h
+Notes:
+    -a field left 0 keeps its default: 1000, 5 and 2000 respectively, no
+     standby, then 5 revives in 60000, with backoff from 1000 to 30000, and
+     1 false positive in a million
+    -the adaptive detection only works over the shared memory page, whose
+     beats carry their time. Over signals only miss_threshold counts
+    -every wait is randomly cut by up to half, so processes that crash
+     together don't come back together
+*/
+typedef struct wd_config
+{
+    unsigned long heartbeat_ms;
+    unsigned long miss_threshold;
+    unsigned long stop_poll_ms;
+    unsigned long warm_standby;
+    unsigned long restart_budget;
+    unsigned long restart_window_ms;
+    unsigned long backoff_ms;
+    unsigned long backoff_max_ms;
+    unsigned long false_positive_ppm;
+} wd_config_t;
+
 /*
 compile with:
 gd -pthread watchdog.c watchdog_client.c scheduler.c pqueue.c srtlist.c dlist.c task.c uid.c -I../inc -lm -o watchdog.out
@@ -24,10 +93,40 @@ Return:
         -SUCCESS: section is protected
         -FAILURE: section isn't protected
 Notes:
-    -this utility uses SIGUSR1 SIGUSR2 signals
+    -the two sides beat over a shared memory page, whose descriptor is
+     passed on in the WD_SHM_FD environment variable. Only if the page
+     can't be created, this utility uses SIGUSR1 SIGUSR2 signals instead,
+     and then keeps no trace for wd_trace to read
+    -if WD_SUPERVISOR holds the socket path of a running wd_supervisor, no
+     watchdog process is started, the supervisor watches and revives the
+     process instead, see wd_supervisor.h
 */
 wd_status_t WDStart(const char **cmd);
 
+/*
+Description:
+    -Same as WDStart, with the given timing instead of the default one. The
+     watchdog process and every revived process use the same timing
+Params:
+    -cmd: command line to reinitiate the process {"./a.out", "arguments"...}
+    -cfg: timing of the pair, NULL for the defaults
+Return:
+    -status:
+        -SUCCESS: section is protected
+        -FAILURE: section isn't protected
+Notes:
+    -the timing is passed on in the WD_CONFIG environment variable
+    -with warm_standby, the watchdog starts a second instance of the process
+     right away, with WD_STANDBY set in its environment. It runs up to its
+     own call to WDStart and parks there, so when the process has to be
+     revived the standby only has to be let through: exec, linking and all
+     the initialization before WDStart are already done. A new standby is
+     started once it took over. Initialization should have no effect
+     outside the process (e.g. binding a port) before WDStart, since both
+     instances run it at the same time. A standby dies with its watchdog
+*/
+wd_status_t WDStartEx(const char **cmd, const wd_config_t *cfg);
+
 /*
 Description:
     -Ends the critical section
@@ -36,4 +135,153 @@ Notes:
 */
 void WDStop(void);
 
+/*
+Description:
+    -Tells where the watchdog of the process stands
+Return:
+    -state: see wd_state_t. Once WD_STATE_GAVE_UP, WDStop still has to be
+     called to free the resources
+Notes:
+    -revives are counted on the shared memory page, over signals every
+     revive is immediate
+    -the watchdog process gives up on a user process that died too often
+     by exiting, there's no one left to tell
+*/
+wd_state_t WDGetState(void);
+
+/*
+Description:
+    -Copies the last revives of either side, the newest first, with the
+     time of every phase from the last beat to the two sides in sync again,
+     see wd_incident_t in wd_shm.h
+Params:
+    -incidents: where to copy them
+    -max: how many to copy at most
+Return:
+    -how many were copied, up to WD_INCIDENTS. 0 without a shared page
+Notes:
+    -the revives are kept on the shared page, so those done by the watchdog
+     process show up too, along with those from before this process was
+     itself revived
+*/
+size_t WDGetIncidents(wd_incident_t *incidents, size_t max);
+
+/*
+Description:
+    -Writes the last revives as a table, one line each, with how long every
+     phase took in milliseconds: detect (last beat to declared), spawn,
+     start (spawned to WDStart) and sync, then the total
+Params:
+    -fd: where to write it, e.g. STDERR_FILENO
+*/
+void WDDumpIncidents(int fd);
+
+/*
+Description:
+    -Has the watchdog watch the calling thread on top of the process: the
+     thread must call WDKick at least once every timeout_ms, or the process
+     is killed and revived as if it hung
+Params:
+    -timeout_ms: the deadline between two kicks
+Return:
+    -the id to kick with, -1 if the thread can't be watched
+Notes:
+    -to be called after WDStart. Only works over the shared memory page,
+     and for up to WD_THREADS (see wd_shm.h) threads at once
+    -the deadline is checked every heartbeat_ms, so a stall is caught
+     between timeout_ms and timeout_ms + heartbeat_ms after the last kick
+    -a thread that's done must call WDUnregisterThread before it exits
+*/
+int WDRegisterThread(unsigned long timeout_ms);
+
+/*
+Description:
+    -Signs the thread as making progress, a single relaxed store to shared
+     memory, cheap enough for every iteration of a busy loop
+Params:
+    -id: as returned by WDRegisterThread, only the registering thread may
+     kick it. -1 is ignored
+*/
+void WDKick(int id);
+
+/*
+Description:
+    -Stops watching a thread registered with WDRegisterThread
+Params:
+    -id: as returned by WDRegisterThread, -1 is ignored
+*/
+void WDUnregisterThread(int id);
+
+/*
+Description:
+    -Has the watchdog hold on to the state of the process, to hand it to
+     the process that replaces it once it's revived, e.g. a memfd or a
+     shared memory file the process maps and keeps its state in
+Params:
+    -fd: descriptor of the state, it's duplicated so the caller may close it
+Return:
+    -status:
+        -SUCCESS: the watchdog holds the state
+        -FAILURE: the state couldn't be handed over, it's still kept and
+         sent to the next watchdog revived
+Notes:
+    -to be called after WDStart, again with a new descriptor to replace it.
+     The state is passed over a unix socket, with no copy of its content:
+     whatever the process wrote to it is what the next one finds
+    -the process holds its own reference too, and passes it on to a
+     watchdog it revives, so the state outlives either side dying
+    -not supported under a supervisor
+*/
+wd_status_t WDRegisterState(int fd);
+
+/*
+Description:
+    -Hands the state registered by the process this one replaces over to
+     the caller, see WDRegisterState
+Return:
+    -the descriptor of the state, owned by the caller. -1 if the process
+     wasn't revived, no state was registered, or it was already taken
+Notes:
+    -to be called after WDStart. The state is still held by the watchdog
+     until the process registers another one
+*/
+int WDGetRecoveredState(void);
+
+/*
+Description:
+    -Has the pair keep the listening sockets of the process open across its
+     revives. Every process the pair spawns inherits them, the revived
+     process takes them with WDGetListenFds instead of binding again, so
+     connections made while it's down wait in the backlog instead of being
+     refused
+Params:
+    -fds: the listening sockets, duplicated so the caller may close them
+    -n: how many, up to WD_LISTEN_MAX
+Return:
+    -status:
+        -SUCCESS: the sockets are kept
+        -FAILURE: too many sockets, or they couldn't be duplicated
+Notes:
+    -to be called before WDStart, the watchdog process inherits them when
+     it's started. Replaces the sockets registered or inherited before
+    -a standby (see WDStartEx) inherits them too, so it can take them during
+     its own initialization without binding a second time
+    -not supported under a supervisor
+*/
+wd_status_t WDRegisterListenFds(const int *fds, size_t n);
+
+/*
+Description:
+    -Copies the listening sockets inherited from the process this one
+     replaces, see WDRegisterListenFds
+Params:
+    -fds: where to put them, duplicates owned by the caller
+    -max: how many to put at most
+Return:
+    -how many were put, 0 if the process wasn't revived or none were kept
+Notes:
+    -may be called before WDStart, to skip binding
+*/
+size_t WDGetListenFds(int *fds, size_t max);
+
 #endif /* __ILRD_WD_1556__ */
\ No newline at end of file
@@ -0,0 +1,73 @@
+/*
+	Name: Guy Feigin
+	Exercise: Phi accrual failure detector
+	File type: Header
+	Reviewer:
+	Last updated: Sun 18 Oct 2026 01:20:06
+*/
+
+#ifndef WD_PHI_H
+#define WD_PHI_H
+
+#include <stdint.h> /* uint64_t */
+
+/******************************************************************************/
+/* Tells how likely it is that a process sending heartbeats has failed,		  */
+/* rather than a fixed count of missed beats. It keeps the intervals between  */
+/* the last beats and takes them as normally distributed: the suspicion phi	  */
+/* is -log10 of the chance that a beat still comes after as long as it's	  */
+/* been since the last one. A phi of 3 means the process is taken for		  */
+/* failed wrongly once in 1000 times. On a steady process the suspicion		  */
+/* rises fast, on one whose beats come with jitter it rises slowly.			  */
+
+/******************************************************************************/
+/* How many of the last intervals the distribution is made of				  */
+#define WD_PHI_WINDOW (64)
+
+/******************************************************************************/
+/* type definition for the detector											  */
+typedef struct wd_phi wd_phi_t;
+
+/******************************************************************************/
+/* Description:  Creates a detector with no beats yet						  */
+/* Arguments:    heartbeat_ms - how often the process beats. The spread of	  */
+/*				 the intervals is never taken below a quarter of it, so a	  */
+/*				 process that was very steady isn't suspected for the		  */
+/*				 slightest delay											  */
+/*				 false_positive_ppm - how often in a million the process	  */
+/*				 may be taken for failed while it's only late, not 0		  */
+/* Return value: returns a pointer to the new detector, NULL on failure		  */
+wd_phi_t *WDPhiCreate(unsigned long heartbeat_ms, 
+					  unsigned long false_positive_ppm); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Frees memory of a given detector							  */
+void WDPhiDestroy(wd_phi_t *phi); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Forgets every beat, for a new process that beats instead	  */
+void WDPhiReset(wd_phi_t *phi); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Records the last beat of the process, as seen on the page	  */
+/*				 (see WDShmGetBeat). Beats that were skipped over count as	  */
+/*				 evenly spread between the last one seen and this one		  */
+/* Arguments:    phi - pointer to the detector								  */
+/*				 seq - the sequence number of the beat						  */
+/*				 beat_ns - its CLOCK_MONOTONIC time							  */
+/* Return value: None														  */
+void WDPhiBeat(wd_phi_t *phi, uint64_t seq, uint64_t beat_ns); /* O(window) */
+
+/******************************************************************************/
+/* Description:  Computes the suspicion of the process now					  */
+/* Arguments:    phi - pointer to the detector								  */
+/* Return value: returns phi, 0 until enough beats were recorded to tell	  */
+double WDPhiGet(const wd_phi_t *phi); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Checks the suspicion now against the false positive rate	  */
+/*				 the detector was created with								  */
+/* Return value: returns 1 if the process is taken for failed, 0 otherwise	  */
+int WDPhiIsSuspect(const wd_phi_t *phi); /* O(1) */
+
+#endif /* WD_PHI_H */
@@ -0,0 +1,334 @@
+/*
+	Name: Guy Feigin
+	Exercise: Watchdog shared page
+	File type: Header
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 22:05:13
+*/
+
+#ifndef WD_SHM_H
+#define WD_SHM_H
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+#include <sys/types.h> /* pid_t */
+
+/******************************************************************************/
+/* A page of memory shared by the two sides of a watchdog pair. It lives in	  */
+/* an anonymous memory file, so it is passed on to a new process simply by	  */
+/* letting it inherit the descriptor across fork and exec. Each side proves	  */
+/* it is alive by bumping its own sequence counter, the other side polls it.  */
+/* A beat is two stores and a check is a load, no signal or system call.	  */
+/* The two sides hand shake over a pair of semaphores on the page, so		  */
+/* every pair has its own, with no name to clash with other pairs.			  */
+/* The page also holds a table of progress slots, one per thread of the	  */
+/* user side that asked to be watched, see WDShmClaimThread, and a ring of	  */
+/* the last revives of either side, see WDShmOpenIncident, and a trace of	  */
+/* the last events of each side, see WDShmTrace. Since the page outlives	  */
+/* the process that wrote them, they can be read after it crashed.			  */
+
+/******************************************************************************/
+/* The sides of the pair, each owns one slot of the page					  */
+typedef enum wd_side
+{
+	WD_SIDE_USER = 0,
+	WD_SIDE_WD,
+	WD_SIDES
+} wd_side_t;
+
+/******************************************************************************/
+/* How many threads of the user side may be watched at once					  */
+#define WD_THREADS (32)
+
+/******************************************************************************/
+/* How many of the last revives are kept on the page						  */
+#define WD_INCIDENTS (16)
+
+/******************************************************************************/
+/* Why a side had to be revived												  */
+typedef enum wd_cause
+{
+	WD_CAUSE_EXITED = 0,
+	WD_CAUSE_HUNG,
+	WD_CAUSE_STALLED
+} wd_cause_t;
+
+/******************************************************************************/
+/* The phases of a revive, in the order they happen. All are CLOCK_MONOTONIC  */
+/* times, which every process on the machine shares.						  */
+/*	LAST_SEEN - the last beat of the side before it failed					  */
+/*	DECLARED - the other side decided it failed								  */
+/*	SPAWNED - the new process is about to be spawned, or a standby let		  */
+/*			  through. A revive held back by a backoff includes the wait	  */
+/*	STARTED - the new process got to WDStart, past exec and its init		  */
+/*	SYNCED - the two sides are in sync again, the revive is done			  */
+typedef enum wd_phase
+{
+	WD_PHASE_LAST_SEEN = 0,
+	WD_PHASE_DECLARED,
+	WD_PHASE_SPAWNED,
+	WD_PHASE_STARTED,
+	WD_PHASE_SYNCED,
+	WD_PHASES
+} wd_phase_t;
+
+/******************************************************************************/
+/* A revive of a side, a phase it didn't get to is 0						  */
+typedef struct wd_incident
+{
+	wd_side_t side;
+	wd_cause_t cause;
+	pid_t pid; /* The process that failed */
+	uint64_t phase_ns[WD_PHASES];
+} wd_incident_t;
+
+/******************************************************************************/
+/* How many of the last trace events of each side are kept on the page		  */
+#define WD_TRACE_EVENTS (1024)
+
+/******************************************************************************/
+/* What a side traces, with what the argument of the event is				  */
+/*	START - the side is running, the pid of the other one					  */
+/*	BEAT_SENT - a beat to the other side, its sequence number				  */
+/*	BEAT_SEEN - a new beat of the other side, its sequence number			  */
+/*	CHECK - a check of the other side, how many beats it missed				  */
+/*	EXITED, HUNG - the other side failed, its pid							  */
+/*	STALLED - a watched thread of the user side stalled, its id				  */
+/*	BACKOFF - the revive waits, for how many milliseconds					  */
+/*	REVIVE - the other side is back, its new pid							  */
+/*	GAVE_UP - the other side isn't revived anymore, 0						  */
+/*	STOP - the side was asked to stop, 0									  */
+typedef enum wd_event
+{
+	WD_EVENT_START = 0,
+	WD_EVENT_BEAT_SENT,
+	WD_EVENT_BEAT_SEEN,
+	WD_EVENT_CHECK,
+	WD_EVENT_EXITED,
+	WD_EVENT_HUNG,
+	WD_EVENT_STALLED,
+	WD_EVENT_BACKOFF,
+	WD_EVENT_REVIVE,
+	WD_EVENT_GAVE_UP,
+	WD_EVENT_STOP,
+	WD_EVENTS
+} wd_event_t;
+
+/******************************************************************************/
+/* An event traced by a side, ns is a CLOCK_MONOTONIC time					  */
+typedef struct wd_trace_event
+{
+	uint64_t ns;
+	uint64_t arg;
+	pid_t pid; /* The process that traced it */
+	wd_side_t side;
+	wd_event_t event;
+} wd_trace_event_t;
+
+/******************************************************************************/
+/* Returned by WDShmRestartDelay once a side restarted too often			  */
+#define WD_GIVE_UP (-1)
+
+/******************************************************************************/
+/* How often a side may be restarted: up to budget restarts in window_ms,	  */
+/* the first one right away and the next ones after a delay starting at		  */
+/* backoff_ms and doubling up to backoff_max_ms. No field may be 0			  */
+typedef struct wd_restart_policy
+{
+	unsigned long budget;
+	unsigned long window_ms;
+	unsigned long backoff_ms;
+	unsigned long backoff_max_ms;
+} wd_restart_policy_t;
+
+/******************************************************************************/
+/* type definition for a process' handle to the page						  */
+typedef struct wd_shm wd_shm_t;
+
+/******************************************************************************/
+/* Description:  Creates a new zeroed page. Its descriptor is inherited by	  */
+/*				 children and survives exec								  */
+/* Arguments:    None														  */
+/* Return value: returns a handle to the page, NULL on failure				  */
+wd_shm_t *WDShmCreate(void); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Maps a page created by another process. The handle takes	  */
+/*				 ownership of the descriptor								  */
+/* Arguments:    fd - descriptor of the page, as given by WDShmGetFd		  */
+/* Return value: returns a handle to the page, NULL on failure				  */
+wd_shm_t *WDShmAttach(int fd); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Unmaps the page and closes its descriptor. The page itself	  */
+/*				 is gone once no process holds it anymore					  */
+/* Arguments:    shm - handle to the page									  */
+/* Return value: None														  */
+void WDShmDetach(wd_shm_t *shm); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Returns the descriptor of the page, to pass on to another	  */
+/*				 process													  */
+int WDShmGetFd(const wd_shm_t *shm); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Signs a side as alive: bumps its sequence number and stamps  */
+/*				 it with the monotonic clock								  */
+/* Arguments:    shm - handle to the page									  */
+/*				 side - the side beating, only one thread per side may beat	  */
+/* Return value: None														  */
+void WDShmBeat(wd_shm_t *shm, wd_side_t side); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Reads the last beat of a side								  */
+/* Arguments:    shm - handle to the page									  */
+/*				 side - the side to check									  */
+/*				 beat_ns - if not NULL, set to the CLOCK_MONOTONIC time of	  */
+/*				 the beat in nanoseconds, 0 if the side never beat			  */
+/* Return value: returns the sequence number of the beat, it only grows		  */
+uint64_t WDShmGetBeat(const wd_shm_t *shm, wd_side_t side,
+					  uint64_t *beat_ns); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Blocks on the gate of the page until it's opened. A gate	  */
+/*				 opened while no one waits lets the next waiter through		  */
+/* Arguments:    shm - handle to the page									  */
+/* Return value: None														  */
+void WDShmGateWait(wd_shm_t *shm);
+
+/******************************************************************************/
+/* Description:  Opens the gate of the page for a single waiter				  */
+void WDShmGateOpen(wd_shm_t *shm); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Counts a restart of a side, and tells how long to wait		  */
+/*				 before it. The count is kept on the page, so it carries	  */
+/*				 over to whoever revives the side next. The delay is		  */
+/*				 randomly cut by up to half, so sides that died together	  */
+/*				 don't come back together									  */
+/* Arguments:    shm - handle to the page									  */
+/*				 side - the side about to be restarted, only one process	  */
+/*				 may restart a side											  */
+/*				 policy - the budget and backoff of the side				  */
+/* Return value: returns the delay in milliseconds, 0 to restart right away,  */
+/*				 WD_GIVE_UP once the budget of the window is spent			  */
+long WDShmRestartDelay(wd_shm_t *shm, wd_side_t side, 
+					   const wd_restart_policy_t *policy); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Records that a side failed and is about to be revived, in	  */
+/*				 place of the oldest incident. Stamps its last beat and the	  */
+/*				 time now, and makes it the side's incident in progress		  */
+/* Arguments:    shm - handle to the page									  */
+/*				 side - the side that failed								  */
+/*				 cause - why it's revived									  */
+/*				 pid - the process that failed								  */
+/* Return value: None														  */
+void WDShmOpenIncident(wd_shm_t *shm, wd_side_t side, wd_cause_t cause, 
+					   pid_t pid); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Stamps a phase of the side's incident in progress with the	  */
+/*				 time now, if there is one. WD_PHASE_SYNCED ends it			  */
+/* Arguments:    shm - handle to the page									  */
+/*				 side - the side being revived								  */
+/*				 phase - the phase it just got to							  */
+/* Return value: None														  */
+void WDShmMarkIncident(wd_shm_t *shm, wd_side_t side, 
+					   wd_phase_t phase); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Copies the last incidents, the newest first. One still in	  */
+/*				 progress has the phases it didn't get to yet at 0			  */
+/* Arguments:    shm - handle to the page									  */
+/*				 incidents - where to copy them								  */
+/*				 max - how many to copy at most								  */
+/* Return value: returns how many were copied, up to WD_INCIDENTS			  */
+size_t WDShmGetIncidents(const wd_shm_t *shm, wd_incident_t *incidents, 
+						 size_t max); /* O(max) */
+
+/******************************************************************************/
+/* Description:  Traces an event in place of the oldest one of the side. A	  */
+/*				 few relaxed stores with no lock or system call, so it's	  */
+/*				 async-signal-safe and may be called from any thread		  */
+/* Arguments:    shm - handle to the page									  */
+/*				 side - the side tracing									  */
+/*				 event - what happened										  */
+/*				 arg - see wd_event_t										  */
+/* Return value: None														  */
+void WDShmTrace(wd_shm_t *shm, wd_side_t side, wd_event_t event, 
+				uint64_t arg); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Copies the last events traced by a side, the oldest first.  */
+/*				 An event being written while it's read is left out			  */
+/* Arguments:    shm - handle to the page									  */
+/*				 side - the side to read									  */
+/*				 events - where to copy them								  */
+/*				 max - how many to copy at most								  */
+/* Return value: returns how many were copied, up to WD_TRACE_EVENTS		  */
+size_t WDShmGetTrace(const wd_shm_t *shm, wd_side_t side, 
+					 wd_trace_event_t *events, size_t max); /* O(max) */
+
+/******************************************************************************/
+/* Description:  Wakes a side waiting in WDShmWait, or the next one to wait	  */
+/* Arguments:    shm - handle to the page									  */
+/*				 side - the side to wake									  */
+/* Return value: None														  */
+void WDShmPost(wd_shm_t *shm, wd_side_t side); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Waits for the other side to post to this one. Every post	  */
+/*				 lets a single wait through									  */
+/* Arguments:    shm - handle to the page									  */
+/*				 side - the side waiting									  */
+/*				 timeout_ms - the longest to wait, 0 only takes a post		  */
+/*				 that's already there										  */
+/* Return value: returns 0 once posted to, 1 if timed out					  */
+int WDShmWait(wd_shm_t *shm, wd_side_t side, unsigned long timeout_ms);
+
+/******************************************************************************/
+/* Description:  Asks a side to stop, it's never cleared					  */
+void WDShmStop(wd_shm_t *shm, wd_side_t side); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Checks if a side was asked to stop. Returns 1 if so, 0		  */
+/*				 otherwise													  */
+int WDShmIsStopped(const wd_shm_t *shm, wd_side_t side); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Claims a free progress slot for the calling thread. The	  */
+/*				 thread is stalled once it goes longer than timeout_ms		  */
+/*				 without a kick												  */
+/* Arguments:    shm - handle to the page									  */
+/*				 timeout_ms - the deadline between two kicks, not 0			  */
+/* Return value: returns the id of the slot, -1 if all WD_THREADS are taken	  */
+int WDShmClaimThread(wd_shm_t *shm, unsigned long timeout_ms); /* O(threads) */
+
+/******************************************************************************/
+/* Description:  Frees a slot, its thread isn't watched anymore				  */
+void WDShmReleaseThread(wd_shm_t *shm, int id); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Signs the thread owning a slot as making progress, a single  */
+/*				 relaxed store. Only the owner of the slot may kick it		  */
+/* Arguments:    shm - handle to the page									  */
+/*				 id - the slot, as returned by WDShmClaimThread				  */
+/* Return value: None														  */
+void WDShmKick(wd_shm_t *shm, int id); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Checks every armed slot against its deadline. A slot is	  */
+/*				 timed from the first check that saw its last kick, so it's	  */
+/*				 found stalled up to one check interval late. To be called	  */
+/*				 periodically by a single checking process					  */
+/* Arguments:    shm - handle to the page									  */
+/* Return value: returns the id of a stalled slot, -1 if none is stalled	  */
+int WDShmFindStalled(wd_shm_t *shm); /* O(threads) */
+
+/******************************************************************************/
+/* Description:  Frees all the slots. To be called by the checking side		  */
+/*				 before it revives the user side, whose threads are gone	  */
+void WDShmResetThreads(wd_shm_t *shm); /* O(threads) */
+
+#endif /* WD_SHM_H */
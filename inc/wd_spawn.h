@@ -0,0 +1,51 @@
+/*
+	Name: Guy Feigin
+	Exercise: Watchdog spawn
+	File type: Header
+	Reviewer:
+	Last updated: Sun 18 Oct 2026 10:02:31
+*/
+
+#ifndef WD_SPAWN_H
+#define WD_SPAWN_H
+
+#include <stddef.h> /* size_t */
+#include <sys/types.h> /* pid_t */
+
+/******************************************************************************/
+/* How every process of a watchdog pair, or of a supervisor, is started.	  */
+/* The executable is resolved once, when the process to be watched starts,	  */
+/* so a revive doesn't depend on the working directory or PATH of the		  */
+/* moment. The spawn itself is a posix_spawn, which doesn't copy the page	  */
+/* tables of the caller the way fork does, so its cost doesn't grow with	  */
+/* the size of the process spawning.										  */
+
+/******************************************************************************/
+/* Description:  Finds the absolute path of an executable, the way execvp	  */
+/*				 would: a name with a slash is taken relative to the		  */
+/*				 working directory, any other one is looked up in PATH		  */
+/* Arguments:    name - the name of the executable, e.g. argv[0]			  */
+/*				 resolved - where to write the path, PATH_MAX bytes			  */
+/* Return value: returns 0 on success, 1 if there's no such executable		  */
+int WDSpawnResolve(const char *name, char *resolved); /* O(PATH) */
+
+/******************************************************************************/
+/* Description:  Starts a process, with the environment of the caller		  */
+/*				 and SIGCHLD back to its default							  */
+/* Arguments:    pid - set to the pid of the new process					  */
+/*				 path - the resolved executable								  */
+/*				 argv - its arguments, NULL terminated						  */
+/*				 dir - its working directory, NULL for the caller's			  */
+/*				 fds - descriptors to keep open in it at the same numbers,	  */
+/*				 even if close-on-exec										  */
+/*				 n_fds - how many										  	  */
+/*				 env - "NAME=value" entries, NULL terminated, added to the	  */
+/*				 environment in place of those with the same names. NULL	  */
+/*				 for none													  */
+/* Return value: returns 0 on success, 1 on failure							  */
+/* Notes:        the environment of the caller is read, not changed, so		  */
+/*				 other threads may keep using it							  */
+int WDSpawn(pid_t *pid, const char *path, char *const argv[], const char *dir,
+			const int *fds, size_t n_fds, char *const env[]);
+
+#endif /* WD_SPAWN_H */
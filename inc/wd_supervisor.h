@@ -0,0 +1,87 @@
+/*
+	Name: Guy Feigin
+	Exercise: Watchdog supervisor
+	File type: Header
+	Reviewer:
+	Last updated: Sun 18 Oct 2026 00:12:40
+*/
+
+#ifndef WD_SUPERVISOR_H
+#define WD_SUPERVISOR_H
+
+#include <stddef.h> /* size_t */
+
+#include "wd_shm.h" /* wd_restart_policy_t */
+
+/******************************************************************************/
+/* A single process that watches many clients, instead of a watchdog process  */
+/* per client. Clients register over a unix socket, handing over their		  */
+/* shared page (see wd_shm.h) along with their command line. All their		  */
+/* heartbeat checks run in one timing wheel scheduler. A client whose		  */
+/* connection closes without having asked to stop has died and is revived,	  */
+/* one that stops beating is killed first, as soon as its beats became		  */
+/* unlikely enough to still come, see wd_phi.h. A revived client finds the	  */
+/* socket in WD_SUPERVISOR and its page in WD_SHM_FD, and registers again.	  */
+/* Revives are counted on the client's page against its restart policy, so	  */
+/* one that keeps dying is revived with backoff, then not at all. A revive  */
+/* spawns the executable argv[0] resolved to at registration, in the		  */
+/* client's working directory, so it doesn't depend on PATH at that time.	  */
+
+/******************************************************************************/
+/* type definition for the supervisor										  */
+typedef struct wd_supervisor wd_supervisor_t;
+
+/******************************************************************************/
+/* Description:  Creates a supervisor listening on a unix socket. A stale	  */
+/*				 socket file at the path is replaced. Only the user running	  */
+/*				 the supervisor may connect to it, and a client is known by	  */
+/*				 the pid the kernel gives for its connection				  */
+/* Arguments:    path - path of the socket									  */
+/* Return value: returns a pointer to the new supervisor, NULL on failure	  */
+wd_supervisor_t *WDSupervisorCreate(const char *path); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Frees the supervisor and removes its socket file. Clients	  */
+/*				 still registered are left running unwatched				  */
+/* Arguments:    sup - pointer to the supervisor							  */
+/* Return value: None														  */
+void WDSupervisorDestroy(wd_supervisor_t *sup); /* O(clients) */
+
+/******************************************************************************/
+/* Description:  Serves clients until WDSupervisorStop is called. Children	  */
+/*				 are reaped by ignoring SIGCHLD in the calling process		  */
+/* Arguments:    sup - pointer to the supervisor							  */
+/* Return value: returns 0 once stopped, 1 on failure						  */
+int WDSupervisorRun(wd_supervisor_t *sup);
+
+/******************************************************************************/
+/* Description:  Makes WDSupervisorRun return within 100 ms. Safe to call	  */
+/*				 from a signal handler										  */
+void WDSupervisorStop(wd_supervisor_t *sup); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Counts the registered clients								  */
+size_t WDSupervisorCount(const wd_supervisor_t *sup); /* O(1) */
+
+/******************************************************************************/
+/* Description:  Registers the calling process with a supervisor. To be		  */
+/*				 called by the client, it blocks until the supervisor		  */
+/*				 watches it. The client stops being watched once it asked	  */
+/*				 to stop on its page and closed the returned socket			  */
+/* Arguments:    path - path of the supervisor's socket						  */
+/*				 shm_fd - descriptor of the client's shared page			  */
+/*				 argv - command line that revives the client, argv[0] is	  */
+/*				 resolved against PATH now								  */
+/*				 heartbeat_ms - how often the client beats					  */
+/*				 miss_threshold - missed beats after which it's killed		  */
+/*				 false_positive_ppm - how often in a million it may be		  */
+/*				 killed for a beat that's only late, see wd_phi.h			  */
+/*				 restart - how often it may be revived, see wd_shm.h		  */
+/* Return value: returns the connected socket, -1 on failure				  */
+int WDSupervisorRegister(const char *path, int shm_fd, char *const argv[],
+						 unsigned long heartbeat_ms,
+						 unsigned long miss_threshold,
+						 unsigned long false_positive_ppm,
+						 const wd_restart_policy_t *restart);
+
+#endif /* WD_SUPERVISOR_H */
@@ -0,0 +1,59 @@
+/*
+	Name: Guy Feigin
+	Exercise: Worker pool
+	File type: Header
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 17:22:09
+*/
+
+#ifndef WPOOL_H
+#define WPOOL_H
+
+#include <stddef.h> /* size_t */
+
+/******************************************************************************/
+/* A fixed pool of worker threads that run jobs. Every worker has its own 	  */
+/* deque of jobs, guarded by its own lock. Jobs are handed out round robin,	  */
+/* a worker takes jobs from the front of its own deque, and once it runs dry  */
+/* it steals from the back of the other deques, so one slow job doesn't hold  */
+/* back the jobs queued behind it. Idle workers sleep until a job arrives.	  */
+
+/******************************************************************************/
+/* Description:  Runs a single job. To be defined by the user. It's called on */
+/*				 one of the worker threads								  	  */
+typedef void (*wp_job_func_t)(void *job, void *param);
+
+/******************************************************************************/
+/* type definition for the worker pool										  */
+typedef struct wpool wpool_t;
+
+/******************************************************************************/
+/* Description:  Creates a pool and starts its worker threads				  */
+/* Arguments:    n_workers - number of worker threads, must not be 0		  */
+/*				 job_func - runs a job										  */
+/*				 param - parameter to be sent to the job function			  */
+/* Return value: returns a pointer to the new pool, NULL on failure			  */
+wpool_t *WPoolCreate(size_t n_workers, wp_job_func_t job_func,
+					 void *param); /* O(n_workers) */
+
+/******************************************************************************/
+/* Description:  Runs the jobs that are still queued, then stops and joins	  */
+/*				 the worker threads and frees the pool. Must not be called	  */
+/*				 from a worker thread										  */
+/* Arguments:    pool - pointer to the pool									  */
+/* Return value: None														  */
+void WPoolDestroy(wpool_t *pool); /* O(n_workers) */
+
+/******************************************************************************/
+/* Description:  Queues a job to be run by one of the workers. Safe to call	  */
+/*				 from any thread											  */
+/* Arguments:    pool - pointer to the pool									  */
+/*				 job - the job to be run, must not be NULL					  */
+/* Return value: returns 0 on success, 1 if the deque failed to grow		  */
+int WPoolSubmit(wpool_t *pool, void *job); /* amortized O(1) */
+
+/******************************************************************************/
+/* Description:  Counts the worker threads of the pool						  */
+size_t WPoolSize(const wpool_t *pool); /* O(1) */
+
+#endif /* WPOOL_H */
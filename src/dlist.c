@@ -12,6 +12,9 @@ Last Updated: Feb 20
 
 #include "dlist.h" /* dlist_t */
 
+#define POOL_DEFAULT_CHUNK (16)
+#define POOL_MAX_CHUNK (4096)
+
 enum status
 {
 	INSERT_FAIL = -2,
@@ -20,18 +23,43 @@ enum status
 };
 
 typedef struct dlist_node node_t;
+typedef struct pool_chunk chunk_t;
 
 struct dlist_node
 {
     void *data;
     node_t *next;
     node_t *prev;
+    dlist_pool_t *pool;
 };
 
 struct dlist
 {
     node_t head;
     node_t tail;
+    dlist_pool_t *pool;
+};
+
+/*
+	Nodes are carved out of chunks and recycled through a free list that is
+	threaded through their next pointers. A node always goes back to the pool
+	it came from, even after it was spliced into a list of another pool, so
+	the pool is kept alive while any list or live node still refers to it.
+*/
+struct pool_chunk
+{
+	chunk_t *next;
+	node_t nodes[1];
+};
+
+struct dlist_pool
+{
+	node_t *free_list;
+	chunk_t *chunks;
+	size_t chunk_nodes;
+	size_t refs;
+	size_t live;
+	dlist_pool_stats_t stats;
 };
 
 static int CountNodes(void *data, void *param);
@@ -39,19 +67,49 @@ static dlist_iter_t NodeToIter(node_t *node);
 static node_t *IterToNode(dlist_iter_t iter);
 static dlist_iter_t GoToEnd(dlist_iter_t iter);
 static node_t *CreateNode();
+static void FreeNode(node_t *node);
+static int PoolGrow(dlist_pool_t *pool);
+static void PoolRelease(dlist_pool_t *pool);
+static void PoolFreeIfUnused(dlist_pool_t *pool);
 
 dlist_t *DListCreate()
 {
-	dlist_t *list = (dlist_t *)malloc(sizeof(dlist_t));
+	dlist_t *list = NULL;
+	dlist_pool_t *pool = DListPoolCreate(POOL_DEFAULT_CHUNK);
+	if (!pool)
+	{
+		return NULL;
+	}
+	
+	list = DListCreateWithPool(pool);
+	
+	/* The list holds the only reference to its private pool */
+	DListPoolDestroy(pool);
+	
+	return list;
+}
+
+dlist_t *DListCreateWithPool(dlist_pool_t *pool)
+{
+	dlist_t *list = NULL;
+	
+	assert(pool);
+	
+	list = (dlist_t *)malloc(sizeof(dlist_t));
 	if (!list)
 	{
 		return NULL;
 	}
 	
+	list->pool = pool;
+	++pool->refs;
+	
 	list->head.next = &list->tail;
 	list->head.prev = NULL;
+	list->head.pool = pool;
 	list->tail.next = NULL;
 	list->tail.prev = &list->head;	
+	list->tail.pool = pool;
 
 	return list;
 }
@@ -68,10 +126,11 @@ void DListDestroy(dlist_t *list)
 	while (!DListIsIterSame(curr, DListEnd(list)))
 	{
 		temp = curr->next;
-		free(curr);
+		FreeNode(curr);
 		curr = temp;	
 	}
 	
+	PoolRelease(list->pool);
 	free(list);
 	
 	list = NULL;
@@ -125,7 +184,8 @@ dlist_iter_t DListInsert(dlist_iter_t where, void* data)
 	assert(where_node);
 	assert(data);
 	
-	new_node = CreateNode(data, where_node, where_node->prev);
+	/* where_node is either a node of the list or its tail, both have a pool */
+	new_node = CreateNode(data, where_node, where_node->prev, where_node->pool);
 	if (!new_node)
 	{
 		return (GoToEnd(where));
@@ -148,7 +208,7 @@ dlist_iter_t DListRemove(dlist_iter_t to_remove)
 	to_remove->prev->next = to_remove->next;
 	to_remove->next->prev = to_remove->prev;
 	
-	free(to_remove);
+	FreeNode(to_remove);
 	
 	return (NodeToIter(to_remove_next));
 }
@@ -309,6 +369,46 @@ void *DListPopFront(dlist_t *list)
 	return (removed_node_data);
 }
 
+dlist_pool_t *DListPoolCreate(size_t chunk_nodes)
+{
+	dlist_pool_t *pool = NULL;
+	
+	assert(chunk_nodes);
+	
+	pool = (dlist_pool_t *)calloc(1, sizeof(dlist_pool_t));
+	if (!pool)
+	{
+		return NULL;
+	}
+	
+	pool->chunk_nodes = chunk_nodes;
+	pool->refs = 1;
+	
+	return (pool);
+}
+
+void DListPoolDestroy(dlist_pool_t *pool)
+{
+	assert(pool);
+	
+	PoolRelease(pool);
+}
+
+dlist_pool_t *DListGetPool(const dlist_t *list)
+{
+	assert(list);
+	
+	return (list->pool);
+}
+
+void DListPoolGetStats(const dlist_pool_t *pool, dlist_pool_stats_t *stats)
+{
+	assert(pool);
+	assert(stats);
+	
+	*stats = pool->stats;
+}
+
 static dlist_iter_t NodeToIter(node_t *node)
 {
 	assert(node);
@@ -335,27 +435,126 @@ static dlist_iter_t GoToEnd(dlist_iter_t iter)
 	return iter;
 }
 
-static node_t *CreateNode(void *data, void *next, void *prev)
+static node_t *CreateNode(void *data, void *next, void *prev, 
+						  dlist_pool_t *pool)
 {
 	node_t *node = NULL;
 	
 	assert(data);
 	assert(next);
 	assert(prev);
+	assert(pool);
 	
-	node = (node_t *)(malloc)(sizeof(node_t));
-	if (!node)
+	if (pool->free_list)
 	{
-		return NULL;
-	}	
+		++pool->stats.hits;
+	}
+	else
+	{
+		++pool->stats.misses;
+		
+		if (SUCCESS != PoolGrow(pool))
+		{
+			return NULL;
+		}
+	}
+	
+	node = pool->free_list;
+	pool->free_list = node->next;
+	--pool->stats.free_nodes;
+	++pool->live;
 	
 	node->data = data;
 	node->next = next;
 	node->prev = prev;
+	node->pool = pool;
 	
 	return node;
 }
 
+static void FreeNode(node_t *node)
+{
+	dlist_pool_t *pool = NULL;
+	
+	assert(node);
+	
+	pool = node->pool;
+	
+	node->next = pool->free_list;
+	pool->free_list = node;
+	++pool->stats.free_nodes;
+	--pool->live;
+	
+	PoolFreeIfUnused(pool);
+}
+
+static int PoolGrow(dlist_pool_t *pool)
+{
+	chunk_t *chunk = NULL;
+	size_t i = 0;
+	
+	assert(pool);
+	
+	chunk = (chunk_t *)malloc(offsetof(chunk_t, nodes) + 
+							  pool->chunk_nodes * sizeof(node_t));
+	if (!chunk)
+	{
+		return FAIL;
+	}
+	
+	for (i = 0; i < pool->chunk_nodes; ++i)
+	{
+		chunk->nodes[i].next = pool->free_list;
+		chunk->nodes[i].pool = pool;
+		pool->free_list = &chunk->nodes[i];
+	}
+	
+	chunk->next = pool->chunks;
+	pool->chunks = chunk;
+	
+	++pool->stats.chunks;
+	pool->stats.free_nodes += pool->chunk_nodes;
+	
+	if (pool->chunk_nodes < POOL_MAX_CHUNK)
+	{
+		pool->chunk_nodes *= 2;
+	}
+	
+	return SUCCESS;
+}
+
+static void PoolRelease(dlist_pool_t *pool)
+{
+	assert(pool);
+	assert(pool->refs);
+	
+	--pool->refs;
+	
+	PoolFreeIfUnused(pool);
+}
+
+/* The pool is freed once no list and no live node refers to it anymore */
+static void PoolFreeIfUnused(dlist_pool_t *pool)
+{
+	chunk_t *chunk = NULL;
+	
+	assert(pool);
+	
+	if (0 != pool->refs || 0 != pool->live)
+	{
+		return;
+	}
+	
+	while (pool->chunks)
+	{
+		chunk = pool->chunks->next;
+		free(pool->chunks);
+		pool->chunks = chunk;
+	}
+	
+	free(pool);
+}
+
 static int CountNodes(void *data, void *param)
 {	
 	(void)data;
@@ -0,0 +1,191 @@
+/*
+	Name: Guy Feigin
+	Exercise: Histogram
+	File type: Source code
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 20:11:52
+*/
+
+#include <stdlib.h> /* calloc() */
+#include <string.h> /* memset() */
+#include <assert.h> /* assert() */
+
+#include "hist.h" /* hist_t */
+
+#define SUB_BITS (3)
+#define SUB_COUNT (1 << SUB_BITS)
+#define SUB_MASK (SUB_COUNT - 1)
+#define N_BUCKETS ((64 - SUB_BITS + 1) << SUB_BITS)
+#define COUNT_MAX (0xFFFFFFFFU)
+
+struct hist
+{
+	uint32_t counts[N_BUCKETS];
+	size_t count;
+	uint64_t min;
+	uint64_t max;
+	uint64_t sum;
+};
+
+static size_t BucketOf(uint64_t value);
+static uint64_t BucketHigh(size_t bucket);
+
+/*							  Global Functions								  */
+/******************************************************************************/
+
+hist_t *HistCreate(void)
+{
+	hist_t *hist = (hist_t *)malloc(sizeof(hist_t));
+	if (!hist)
+	{
+		return (NULL);
+	}
+
+	HistReset(hist);
+
+	return (hist);
+}
+
+void HistDestroy(hist_t *hist)
+{
+	free(hist);
+}
+
+void HistRecord(hist_t *hist, uint64_t value)
+{
+	size_t bucket = 0;
+
+	assert(hist);
+
+	bucket = BucketOf(value);
+
+	/* Saturate rather than wrap around, a full bucket stays the largest */
+	if (COUNT_MAX != hist->counts[bucket])
+	{
+		++hist->counts[bucket];
+	}
+
+	if (0 == hist->count || value < hist->min)
+	{
+		hist->min = value;
+	}
+
+	if (value > hist->max)
+	{
+		hist->max = value;
+	}
+
+	++hist->count;
+	hist->sum += value;
+}
+
+uint64_t HistPercentile(const hist_t *hist, double percent)
+{
+	size_t rank = 0;
+	size_t seen = 0;
+	size_t bucket = 0;
+	uint64_t high = 0;
+
+	assert(hist);
+
+	if (0 == hist->count)
+	{
+		return (0);
+	}
+
+	rank = (size_t)(percent / 100 * hist->count + 0.5);
+	if (0 == rank)
+	{
+		rank = 1;
+	}
+
+	for (bucket = 0; bucket < N_BUCKETS; ++bucket)
+	{
+		seen += hist->counts[bucket];
+		if (seen >= rank)
+		{
+			break;
+		}
+	}
+
+	/* The exact extremes are known, don't report past them */
+	high = BucketHigh(bucket);
+	if (high > hist->max)
+	{
+		high = hist->max;
+	}
+
+	return (high < hist->min ? hist->min : high);
+}
+
+size_t HistCount(const hist_t *hist)
+{
+	assert(hist);
+
+	return (hist->count);
+}
+
+uint64_t HistMin(const hist_t *hist)
+{
+	assert(hist);
+
+	return (hist->min);
+}
+
+uint64_t HistMax(const hist_t *hist)
+{
+	assert(hist);
+
+	return (hist->max);
+}
+
+uint64_t HistMean(const hist_t *hist)
+{
+	assert(hist);
+
+	return (0 == hist->count ? 0 : hist->sum / hist->count);
+}
+
+void HistReset(hist_t *hist)
+{
+	assert(hist);
+
+	memset(hist, 0, sizeof(hist_t));
+}
+
+/*							  Static Functions								  */
+/******************************************************************************/
+
+/*
+	Values below SUB_COUNT get a bucket each. Above that, the highest set bit
+	picks the power of 2 and the SUB_BITS bits below it pick the linear bucket
+	inside it.
+*/
+static size_t BucketOf(uint64_t value)
+{
+	size_t msb = 0;
+
+	if (value < SUB_COUNT)
+	{
+		return ((size_t)value);
+	}
+
+	msb = 63 - __builtin_clzll(value);
+
+	return (((msb - SUB_BITS + 1) << SUB_BITS) +
+			((value >> (msb - SUB_BITS)) & SUB_MASK));
+}
+
+static uint64_t BucketHigh(size_t bucket)
+{
+	size_t shift = 0;
+
+	if (bucket < SUB_COUNT)
+	{
+		return ((uint64_t)bucket);
+	}
+
+	shift = (bucket >> SUB_BITS) - 1;
+
+	return ((((uint64_t)(SUB_COUNT + (bucket & SUB_MASK)) + 1) << shift) - 1);
+}
@@ -0,0 +1,122 @@
+/*
+	Name: Guy Feigin
+	Exercise: MPSC queue
+	File type: Source code
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 15:40:21
+*/
+
+#include <stdlib.h> /* malloc() */
+#include <assert.h> /* assert() */
+
+#include "mpsc.h" /* mpsc_t */
+
+/*
+	Producers link new nodes at the head, the consumer unlinks them from the
+	tail. The stub node keeps the list from ever becoming truly empty, so a
+	push never has to touch the tail and a pop never has to touch the head
+	unless the queue is down to its last node.
+*/
+struct mpsc
+{
+	mpsc_node_t *_Atomic head;
+	mpsc_node_t *tail;
+	mpsc_node_t stub;
+};
+
+/*							  Global Functions								  */
+/******************************************************************************/
+
+mpsc_t *MPSCCreate(void)
+{
+	mpsc_t *queue = (mpsc_t *)malloc(sizeof(mpsc_t));
+	if (!queue)
+	{
+		return (NULL);
+	}
+
+	atomic_init(&queue->stub.next, NULL);
+	atomic_init(&queue->head, &queue->stub);
+	queue->tail = &queue->stub;
+
+	return (queue);
+}
+
+void MPSCDestroy(mpsc_t *queue)
+{
+	assert(queue);
+
+	free(queue);
+}
+
+void MPSCPush(mpsc_t *queue, mpsc_node_t *node)
+{
+	mpsc_node_t *prev = NULL;
+
+	assert(queue);
+	assert(node);
+
+	atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+
+	prev = atomic_exchange_explicit(&queue->head, node, memory_order_acq_rel);
+
+	/* Between the exchange and this store the node is not reachable yet */
+	atomic_store_explicit(&prev->next, node, memory_order_release);
+}
+
+mpsc_node_t *MPSCPop(mpsc_t *queue)
+{
+	mpsc_node_t *tail = NULL;
+	mpsc_node_t *next = NULL;
+
+	assert(queue);
+
+	tail = queue->tail;
+	next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+	/* Skip over the stub, it's never handed out */
+	if (tail == &queue->stub)
+	{
+		if (!next)
+		{
+			return (NULL);
+		}
+
+		queue->tail = next;
+		tail = next;
+		next = atomic_load_explicit(&tail->next, memory_order_acquire);
+	}
+
+	if (next)
+	{
+		queue->tail = next;
+		return (tail);
+	}
+
+	/* A producer has exchanged the head but not linked its node yet */
+	if (tail != atomic_load_explicit(&queue->head, memory_order_acquire))
+	{
+		return (NULL);
+	}
+
+	/* tail is the last node, put the stub behind it so it can be unlinked */
+	MPSCPush(queue, &queue->stub);
+
+	next = atomic_load_explicit(&tail->next, memory_order_acquire);
+	if (next)
+	{
+		queue->tail = next;
+		return (tail);
+	}
+
+	return (NULL);
+}
+
+int MPSCIsEmpty(const mpsc_t *queue)
+{
+	assert(queue);
+
+	return (queue->tail == &queue->stub &&
+			NULL == atomic_load_explicit(&queue->stub.next,
+										 memory_order_acquire));
+}
@@ -8,14 +8,58 @@
 
 #include <stdlib.h> /* malloc() */
 #include <assert.h> /* assert() */
+
 #include "srtlist.h" /* srtlist_t */
+#include "pqueue.h" /* pq_t */
+
+#define HEAP_ARITY (4)
+#define HEAP_INIT_CAPACITY (64)
+#define HEAP_SUCCESS (0)
+#define HEAP_FAIL (1)
+#define HEAP_ENQUEUE_SUCCESS (0)
+#define HEAP_ENQUEUE_FAIL (1)
 
-typedef struct pq
+/*
+	Every heap entry carries the order in which it was enqueued, so elements
+	of equal priority leave the heap in FIFO order just like in the sorted
+	list engine.
+*/
+typedef struct heap_entry
 {
+	void *data;
+	size_t seq;
+} heap_entry_t;
+
+struct pq
+{
+	pq_type_t type;
+	cmp_func_t cmp_func;
+	pq_index_func_t index_func;
 	srtlist_t *pqueue;
-} pq_t;
+	heap_entry_t *heap;
+	size_t size;
+	size_t capacity;
+	size_t seq;
+};
+
+static int HeapInit(pq_t *pq);
+static int HeapGrow(pq_t *pq);
+static int HeapIsBefore(const pq_t *pq, size_t one, size_t other);
+static void HeapSet(pq_t *pq, size_t index, heap_entry_t entry);
+static void HeapSwap(pq_t *pq, size_t one, size_t other);
+static void HeapSiftUp(pq_t *pq, size_t index);
+static void HeapSiftDown(pq_t *pq, size_t index);
+static void *HeapRemoveAt(pq_t *pq, size_t index);
+
+/*							  Global Functions								  */
+/******************************************************************************/
 
 pq_t *PQCreate(cmp_func_t cmp_func)
+{
+	return (PQCreateType(cmp_func, PQ_SRTLIST));
+}
+
+pq_t *PQCreateType(cmp_func_t cmp_func, pq_type_t type)
 {
 	pq_t *pqueue = NULL;
 	
@@ -26,6 +70,26 @@ pq_t *PQCreate(cmp_func_t cmp_func)
 	{
 		return NULL;
 	}
+
+	pqueue->type = type;
+	pqueue->cmp_func = cmp_func;
+	pqueue->index_func = NULL;
+	pqueue->pqueue = NULL;
+	pqueue->heap = NULL;
+	pqueue->size = 0;
+	pqueue->capacity = 0;
+	pqueue->seq = 0;
+
+	if (PQ_HEAP == type)
+	{
+		if (HEAP_SUCCESS != HeapInit(pqueue))
+		{
+			free(pqueue);
+			return NULL;
+		}
+
+		return (pqueue);
+	}
 	
 	pqueue->pqueue = SrtListCreate(cmp_func);
 	if (!pqueue->pqueue)
@@ -41,13 +105,41 @@ void PQDestroy(pq_t *pq)
 {
 	assert(pq);
 	
-	SrtListDestroy(pq->pqueue);
+	if (PQ_HEAP == pq->type)
+	{
+		free(pq->heap);
+	}
+	else
+	{
+		SrtListDestroy(pq->pqueue);
+	}
+
 	free(pq);
 }
 
 int PQEnqueue(pq_t *pq, void *data)
 {
+	heap_entry_t entry;
+
 	assert(pq);
+
+	if (PQ_HEAP == pq->type)
+	{
+		if (pq->size == pq->capacity &&
+			HEAP_SUCCESS != HeapGrow(pq))
+		{
+			return (HEAP_ENQUEUE_FAIL);
+		}
+
+		entry.data = data;
+		entry.seq = pq->seq++;
+		HeapSet(pq, pq->size, entry);
+		++pq->size;
+
+		HeapSiftUp(pq, pq->size - 1);
+
+		return (HEAP_ENQUEUE_SUCCESS);
+	}
 	
 	return(SrtListIsIterSame(SrtListEnd(pq->pqueue), 
 		   					 SrtListInsert(pq->pqueue, data)));
@@ -57,12 +149,26 @@ void *PQDequeue(pq_t *pq)
 {
 	assert(pq);
 	
+	if (PQ_HEAP == pq->type)
+	{
+		assert(pq->size);
+
+		return (HeapRemoveAt(pq, 0));
+	}
+
 	return (SrtListPopFront(pq->pqueue));
 }
 
 void *PQPeek(const pq_t *pq)
 {
 	assert(pq);
+
+	if (PQ_HEAP == pq->type)
+	{
+		assert(pq->size);
+
+		return (pq->heap[0].data);
+	}
 	
 	return (SrtListGetData(SrtListBegin(pq->pqueue)));
 }
@@ -71,12 +177,22 @@ int PQIsEmpty(const pq_t *pq)
 {
 	assert(pq);
 	
+	if (PQ_HEAP == pq->type)
+	{
+		return (0 == pq->size);
+	}
+
 	return (SrtListIsEmpty(pq->pqueue));
 }
 
 size_t PQCount(const pq_t *pq)
 {
 	assert(pq);
+
+	if (PQ_HEAP == pq->type)
+	{
+		return (pq->size);
+	}
 	
 	return (SrtListCount(pq->pqueue));
 }
@@ -85,9 +201,23 @@ void *PQErase(pq_t *pq, match_func_t match_func, void *param)
 {
 	void *removed_data = NULL;
 	srtlist_iter_t srt_iter; 
+	size_t i = 0;
 
 	assert(pq);
 	assert(match_func);
+
+	if (PQ_HEAP == pq->type)
+	{
+		for (i = 0; i < pq->size; ++i)
+		{
+			if (match_func(pq->heap[i].data, param))
+			{
+				return (HeapRemoveAt(pq, i));
+			}
+		}
+
+		return (NULL);
+	}
 	
 	srt_iter = SrtListFindIf(SrtListBegin(pq->pqueue), 
 						   	 SrtListEnd(pq->pqueue), 
@@ -102,13 +232,195 @@ void *PQErase(pq_t *pq, match_func_t match_func, void *param)
 	return (removed_data);			
 }
 
+void PQSetIndexFunc(pq_t *pq, pq_index_func_t index_func)
+{
+	size_t i = 0;
+
+	assert(pq);
+	assert(PQ_HEAP == pq->type);
+
+	pq->index_func = index_func;
+
+	for (i = 0; index_func && i < pq->size; ++i)
+	{
+		index_func(pq->heap[i].data, i);
+	}
+}
+
+void *PQEraseAt(pq_t *pq, size_t index)
+{
+	assert(pq);
+	assert(PQ_HEAP == pq->type);
+
+	return (HeapRemoveAt(pq, index));
+}
+
 void PQClear(pq_t *pq)
 {
 	assert(pq);
 	
+	if (PQ_HEAP == pq->type)
+	{
+		pq->size = 0;
+		return;
+	}
+
 	while (!PQIsEmpty(pq))
 	{
 		PQDequeue(pq);
 	}
 }
 
+/*							  Static Functions								  */
+/******************************************************************************/
+
+static int HeapInit(pq_t *pq)
+{
+	assert(pq);
+
+	pq->heap = (heap_entry_t *)malloc(HEAP_INIT_CAPACITY *
+									  sizeof(heap_entry_t));
+	if (!pq->heap)
+	{
+		return (HEAP_FAIL);
+	}
+
+	pq->capacity = HEAP_INIT_CAPACITY;
+
+	return (HEAP_SUCCESS);
+}
+
+static int HeapGrow(pq_t *pq)
+{
+	heap_entry_t *new_heap = NULL;
+	size_t new_capacity = 0;
+
+	assert(pq);
+
+	new_capacity = pq->capacity * 2;
+
+	new_heap = (heap_entry_t *)realloc(pq->heap,
+									   new_capacity * sizeof(heap_entry_t));
+	if (!new_heap)
+	{
+		return (HEAP_FAIL);
+	}
+
+	pq->heap = new_heap;
+	pq->capacity = new_capacity;
+
+	return (HEAP_SUCCESS);
+}
+
+static int HeapIsBefore(const pq_t *pq, size_t one, size_t other)
+{
+	int result = 0;
+
+	assert(pq);
+
+	result = pq->cmp_func(pq->heap[one].data, pq->heap[other].data);
+
+	return (result < 0 || (0 == result &&
+			pq->heap[one].seq < pq->heap[other].seq));
+}
+
+static void HeapSet(pq_t *pq, size_t index, heap_entry_t entry)
+{
+	pq->heap[index] = entry;
+
+	if (pq->index_func)
+	{
+		pq->index_func(entry.data, index);
+	}
+}
+
+static void HeapSwap(pq_t *pq, size_t one, size_t other)
+{
+	heap_entry_t temp = pq->heap[one];
+
+	HeapSet(pq, one, pq->heap[other]);
+	HeapSet(pq, other, temp);
+}
+
+static void HeapSiftUp(pq_t *pq, size_t index)
+{
+	size_t parent = 0;
+
+	assert(pq);
+
+	while (0 < index)
+	{
+		parent = (index - 1) / HEAP_ARITY;
+
+		if (!HeapIsBefore(pq, index, parent))
+		{
+			break;
+		}
+
+		HeapSwap(pq, index, parent);
+		index = parent;
+	}
+}
+
+static void HeapSiftDown(pq_t *pq, size_t index)
+{
+	size_t first_child = 0;
+	size_t last_child = 0;
+	size_t best = 0;
+	size_t child = 0;
+
+	assert(pq);
+
+	for (;;)
+	{
+		first_child = index * HEAP_ARITY + 1;
+		if (first_child >= pq->size)
+		{
+			break;
+		}
+
+		last_child = first_child + HEAP_ARITY;
+		if (last_child > pq->size)
+		{
+			last_child = pq->size;
+		}
+
+		best = first_child;
+		for (child = first_child + 1; child < last_child; ++child)
+		{
+			if (HeapIsBefore(pq, child, best))
+			{
+				best = child;
+			}
+		}
+
+		if (!HeapIsBefore(pq, best, index))
+		{
+			break;
+		}
+
+		HeapSwap(pq, index, best);
+		index = best;
+	}
+}
+
+static void *HeapRemoveAt(pq_t *pq, size_t index)
+{
+	void *removed_data = NULL;
+
+	assert(pq);
+	assert(index < pq->size);
+
+	removed_data = pq->heap[index].data;
+
+	--pq->size;
+	if (index != pq->size)
+	{
+		HeapSet(pq, index, pq->heap[pq->size]);
+
+		HeapSiftUp(pq, index);
+		HeapSiftDown(pq, index);
+	}
+
+	return (removed_data);
+}
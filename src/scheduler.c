@@ -7,140 +7,436 @@
 */
 
 #include <stdlib.h> /* malloc() */
+#include <string.h> /* memset() */
 #include <assert.h> /* assert() */
-#include <unistd.h> /* sleep() */
+#include <errno.h> /* EINTR */
+#include <time.h> /* clock_nanosleep() */
+#include <stdint.h> /* uint64_t */
+#include <stdatomic.h> /* atomic_int */
+#include <unistd.h> /* read() */
+#include <sys/epoll.h> /* epoll_wait() */
+#include <sys/eventfd.h> /* eventfd() */
+#include <sys/timerfd.h> /* timerfd_settime() */
 
 #include "pqueue.h" /* pqueue_t */
+#include "twheel.h" /* twheel_t */
+#include "uidmap.h" /* uidmap_t */
+#include "mpsc.h" /* mpsc_t */
+#include "wpool.h" /* wpool_t */
+#include "hist.h" /* hist_t */
 #include "scheduler.h" /* action_func_t */
 #include "task.h" /* task_t */
 
 #define PQENQUEUE_SUCCESS (0)
+#define PQENQUEUE_FAIL (1)
+#define NS_PER_SEC (1000000000UL)
+#define NS_PER_MS (1000000UL)
+#define NO_FD (-1)
+#define MAX_EVENTS (4)
+
+typedef struct submission submission_t;
+typedef struct run_stats run_stats_t;
+typedef struct watch watch_t;
 
 static int PriorityRule(const void *data, const void *dest_data);
-static int FindToRemove(const void *data, void *param );
+static void UpdateIndex(void *data, size_t index);
+static size_t WheelKey(const void *data);
+static int DestroyTaskAction(void *data, void *param);
+static scheduler_t *AllocSched(void);
+static void FreeSched(scheduler_t *sched);
+static int InitLoopFds(scheduler_t *sched);
+static void Wake(scheduler_t *sched);
+static int IsHeadDue(scheduler_t *sched);
+static struct timespec HeadDeadline(scheduler_t *sched);
+static void WaitForEvent(scheduler_t *sched, const struct timespec *deadline);
+static void RunWatch(scheduler_t *sched, int fd);
+static size_t NowMs(void);
+static void SleepUntil(const struct timespec *deadline);
+static void DestroyTask(scheduler_t *sched, task_t *task);
+static int IsOwner(const scheduler_t *sched);
+static int Submit(scheduler_t *sched, task_t *task, ilrd_uid_t uid);
+static void Post(scheduler_t *sched, submission_t *submission);
+static void ApplySubmissions(scheduler_t *sched);
+static int AddTask(scheduler_t *sched, task_t *task);
+static int RemoveTask(scheduler_t *sched, ilrd_uid_t task_id);
+static int FinishTask(scheduler_t *sched, task_t *task, int status);
+static void DispatchDueTasks(scheduler_t *sched);
+static void RunJob(void *job, void *param);
+static void CompleteJob(scheduler_t *sched, submission_t *submission);
+
+/* Instrumentation, skipped entirely while stats are disabled */
+static int RunTask(scheduler_t *sched, task_t *task);
+static void RecordRun(scheduler_t *sched, task_t *task, uint64_t start_ns, 
+					  uint64_t end_ns);
+static void RecordDepth(scheduler_t *sched);
+static run_stats_t *CreateRunStats(int with_depth);
+static int DestroyRunStatsAction(void *data, void *param);
+static void DestroyTaskStats(scheduler_t *sched, const task_t *task);
+static void FreeStats(scheduler_t *sched);
+static void Summarize(const hist_t *hist, sched_summary_t *summary);
+static uint64_t NowNs(void);
+
+/* Queue operations, dispatched to the heap or to the timing wheel */
+static int QueuePush(scheduler_t *sched, task_t *task);
+static task_t *QueuePop(scheduler_t *sched);
+static void QueueRemove(scheduler_t *sched, task_t *task);
+static size_t QueueCount(const scheduler_t *sched);
+static int QueueIsEmpty(const scheduler_t *sched);
+static int WaitForDueTask(scheduler_t *sched);
+
+enum submission_kind
+{
+    SUBMIT_ADD,
+    SUBMIT_REMOVE,
+    SUBMIT_DONE
+};
+
+/*
+	A request posted to the thread that owns the scheduler: a task to be 
+	added, the uid of a task to be removed, or a task a worker has run 
+	along with the status it returned
+*/
+struct submission
+{
+    mpsc_node_t node;
+    int kind;
+    task_t *task;
+    ilrd_uid_t uid;
+    int status;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+/* An fd being watched, found by its number in the watches of the scheduler */
+struct watch
+{
+    fd_action_func_t action;
+    void *param;
+};
+
+/* Histograms of how late tasks start, how long they run and queue depth */
+struct run_stats
+{
+    hist_t *lateness;
+    hist_t *duration;
+    hist_t *depth;
+};
 
 struct scheduler
 {
     pq_t *priority_queue;
+    twheel_t *wheel;
+    uidmap_t *index;
     task_t *active;
-    int is_running;
+    mpsc_t *submissions;
+    wpool_t *workers;
+    size_t in_flight;
+    int run_status;
+    run_stats_t *stats;
+    uidmap_t *task_stats;
+    watch_t *watches;
+    size_t n_watches;
+    _Atomic(const char *) owner;
+    atomic_int is_running;
+    atomic_int wake_pending;
+    int epoll_fd;
+    int timer_fd;
+    int event_fd;
 };
 
+/* Its address tells the threads apart */
+static __thread char thread_tag;
+
 /******************************* Global Functions *****************************/
 
 scheduler_t *SchedCreate(void)
 {	
-	scheduler_t *sched = (scheduler_t *)malloc(sizeof(scheduler_t));
+	scheduler_t *sched = AllocSched();
 	if (!sched)
 	{
 		return NULL;
 	}
 	
-	sched->priority_queue = PQCreate(PriorityRule);
+	sched->priority_queue = PQCreateType(PriorityRule, PQ_HEAP);
 	if (!sched->priority_queue)
 	{
-		free(sched);
+		FreeSched(sched);
 		return NULL;
 	}
 	
-	sched->active = NULL;
-	sched->is_running = 0;
+	PQSetIndexFunc(sched->priority_queue, UpdateIndex);
 	
 	return (sched);
 }
 
+scheduler_t *SchedCreateWheel(void)
+{
+	scheduler_t *sched = AllocSched();
+	if (!sched)
+	{
+		return NULL;
+	}
+
+	sched->wheel = TWCreate(WheelKey, NowMs());
+	if (!sched->wheel)
+	{
+		FreeSched(sched);
+		return NULL;
+	}
+
+	return (sched);
+}
+
+int SchedSetWorkers(scheduler_t *sched, size_t n_workers)
+{
+	wpool_t *workers = NULL;
+	
+	assert(sched);
+	assert(!sched->is_running);
+	
+	/* Workers report back through the event fd, the loop can't sleep blind */
+	if (0 != n_workers && NO_FD == sched->event_fd)
+	{
+		return ERROR;
+	}
+	
+	if (0 != n_workers)
+	{
+		workers = WPoolCreate(n_workers, RunJob, sched);
+		if (!workers)
+		{
+			return ERROR;
+		}
+	}
+	
+	if (sched->workers)
+	{
+		WPoolDestroy(sched->workers);
+	}
+	
+	sched->workers = workers;
+	
+	return SUCCESS;
+}
+
+int SchedWatchFd(scheduler_t *sched, int fd, fd_action_func_t action, 
+				 void *param)
+{
+	struct epoll_event event = {0};
+	watch_t *watches = NULL;
+	
+	assert(sched);
+	assert(0 <= fd);
+	assert(action);
+	
+	if (NO_FD == sched->epoll_fd)
+	{
+		return ERROR;
+	}
+	
+	/* Watches are indexed by fd, which the kernel keeps small and dense */
+	if ((size_t)fd >= sched->n_watches)
+	{
+		watches = (watch_t *)realloc(sched->watches, 
+									 (fd + 1) * sizeof(watch_t));
+		if (!watches)
+		{
+			return ERROR;
+		}
+		
+		memset(watches + sched->n_watches, 0, 
+			   (fd + 1 - sched->n_watches) * sizeof(watch_t));
+		sched->watches = watches;
+		sched->n_watches = fd + 1;
+	}
+	
+	if (!sched->watches[fd].action)
+	{
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		if (0 != epoll_ctl(sched->epoll_fd, EPOLL_CTL_ADD, fd, &event))
+		{
+			return ERROR;
+		}
+	}
+	
+	sched->watches[fd].action = action;
+	sched->watches[fd].param = param;
+	
+	return SUCCESS;
+}
+
+int SchedUnwatchFd(scheduler_t *sched, int fd)
+{
+	assert(sched);
+	
+	if (0 > fd || (size_t)fd >= sched->n_watches || 
+		!sched->watches[fd].action)
+	{
+		return ERROR;
+	}
+	
+	/* A closed fd has already left the epoll set by itself */
+	epoll_ctl(sched->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+	sched->watches[fd].action = NULL;
+	sched->watches[fd].param = NULL;
+	
+	return SUCCESS;
+}
+
 void SchedDestroy(scheduler_t *sched)
 {
 	assert(sched);
 	
 	SchedClear(sched);
 	
-	PQDestroy(sched->priority_queue);
+	if (sched->wheel)
+	{
+		TWDestroy(sched->wheel);
+	}
+	else
+	{
+		PQDestroy(sched->priority_queue);
+	}
 	
-	free(sched);
+	FreeSched(sched);
 }
 
 ilrd_uid_t SchedAddTask(scheduler_t *sched, size_t interval, 
 						action_func_t action, void *action_param, 
 						cleanup_func_t cleanup_func, 
 						void *cleanup_param)
+{
+	return (SchedAddTaskNs(sched, interval * NS_PER_SEC, action, action_param, 
+						   cleanup_func, cleanup_param));
+}
+
+ilrd_uid_t SchedAddTaskMs(scheduler_t *sched, size_t interval_ms, 
+						  action_func_t action, void *action_param, 
+						  cleanup_func_t cleanup_func, 
+						  void *cleanup_param)
+{
+	return (SchedAddTaskNs(sched, interval_ms * NS_PER_MS, action, 
+						   action_param, cleanup_func, cleanup_param));
+}
+
+ilrd_uid_t SchedAddTaskNs(scheduler_t *sched, size_t interval_ns, 
+						  action_func_t action, void *action_param, 
+						  cleanup_func_t cleanup_func, 
+						  void *cleanup_param)
 {
 	task_t *new_task = NULL;
+	ilrd_uid_t uid;
 	
 	assert(sched);
 	assert(action);
 	
-	new_task = TaskCreate(interval, action, cleanup_func, action_param, 
-								  cleanup_param);
+	new_task = TaskCreateNs(interval_ns, action, cleanup_func, action_param, 
+							cleanup_param);
 	
 	if (!new_task)
 	{
 		return (bad_uid);
 	}
 	
-	if (PQENQUEUE_SUCCESS != PQEnqueue(sched->priority_queue, new_task))
+	uid = TaskGetUID(new_task);
+	
+	/* Other threads hand the task over to the thread that owns the queue */
+	if (!IsOwner(sched))
+	{
+		return (SUCCESS == Submit(sched, new_task, uid) ? uid : bad_uid);
+	}
+	
+	if (SUCCESS != AddTask(sched, new_task))
 	{
-		TaskDestroy(new_task);
 		return (bad_uid);
 	}
 	
-	return (TaskGetUID(new_task));
+	Wake(sched);
+	
+	return (uid);
 }
 
 int SchedRemoveTask(scheduler_t *sched, ilrd_uid_t task_id)
 {
-	void *removed_task = NULL;
-	
 	assert(sched);
 	
-	removed_task = PQErase(sched->priority_queue, FindToRemove, &task_id);
+	if (!IsOwner(sched))
+	{
+		/* Whether the task exists is only known once the owner applies it */
+		return (SUCCESS == Submit(sched, NULL, task_id) ? QUEUED : ERROR);
+	}
+	
+	/* The task may still be waiting in the submission queue */
+	ApplySubmissions(sched);
 	
-	if (removed_task)
+	if (SUCCESS != RemoveTask(sched, task_id))
 	{
-		TaskDestroy(removed_task);
-		return SUCCESS;
+		return ERROR;
 	}
 	
-	return ERROR; 
+	Wake(sched);
+	
+	return SUCCESS;
 }
 
 int SchedRun(scheduler_t *sched)
 {
 	int status = SUCCESS;
+	const char *prev_owner = NULL;
 	
 	assert(sched);
 
+	/* The running thread owns the queue until SchedRun returns */
+	prev_owner = atomic_exchange(&sched->owner, &thread_tag);
 	sched->is_running = 1;
+	sched->run_status = SUCCESS;
 	
-	while (!SchedIsEmpty(sched) && sched->is_running && status == PQENQUEUE_SUCCESS)
+	while (sched->is_running && status == PQENQUEUE_SUCCESS)
 	{			
-		while (TaskGetTimeToRun(PQPeek(sched->priority_queue)) > time(NULL))
+		ApplySubmissions(sched);
+		
+		/* A task that ran on a worker may have ended the run */
+		status = sched->run_status;
+		if (SUCCESS != status || SchedIsEmpty(sched))
 		{
-	  		sleep(1);
+			break;
 		}
 		
-		sched->active = PQDequeue(sched->priority_queue);
-		status = TaskRun(sched->active);
-		
-		if (status == REPEAT)
+		/* Woken up before the head was due, check the loop condition again */
+		if (!WaitForDueTask(sched))
 		{
-			TaskUpdateTimeToRun(sched->active);
-			status = PQEnqueue(sched->priority_queue, sched->active);
-			
-			if (status == 1)
-			{
-				TaskDestroy(sched->active);
-			}
+			continue;
 		}
-		else
+		
+		if (sched->workers)
 		{
-			TaskDestroy(sched->active);
+			DispatchDueTasks(sched);
+			status = sched->run_status;
+			continue;
 		}
-
+		
+		RecordDepth(sched);
+		sched->active = QueuePop(sched);
+		status = FinishTask(sched, sched->active, 
+							RunTask(sched, sched->active));
 		sched->active = NULL;
 	}
 	
+	/* Wait for the tasks that are still running on the workers */
+	for (ApplySubmissions(sched); 0 != sched->in_flight; 
+		 ApplySubmissions(sched))
+	{
+		WaitForEvent(sched, NULL);
+	}
+	
+	if (SUCCESS == status)
+	{
+		status = sched->run_status;
+	}
+	
 	sched->is_running = 0;
+	atomic_store(&sched->owner, prev_owner);
 	
 	return status;
 }
@@ -149,6 +445,11 @@ int SchedStop(scheduler_t *sched)
 {
 	sched->is_running = 0;
 	
+	if (NO_FD != sched->event_fd)
+	{
+		eventfd_write(sched->event_fd, 1);
+	}
+	
 	return STOP;
 }
 
@@ -156,10 +457,28 @@ void SchedClear(scheduler_t *sched)
 {
 	assert(sched);
 	
-	while (!SchedIsEmpty(sched))
+	ApplySubmissions(sched);
+	
+	UIDMapClear(sched->index);
+	
+	if (sched->task_stats)
+	{
+		UIDMapForEach(sched->task_stats, DestroyRunStatsAction, NULL);
+		UIDMapClear(sched->task_stats);
+	}
+	
+	if (sched->wheel)
 	{
-		TaskDestroy((task_t *)(PQPeek(sched->priority_queue)));
-		PQDequeue(sched->priority_queue);
+		TWForEach(sched->wheel, DestroyTaskAction, NULL);
+		TWClear(sched->wheel);
+	}
+	else
+	{
+		while (!QueueIsEmpty(sched))
+		{
+			TaskDestroy((task_t *)(PQPeek(sched->priority_queue)));
+			PQDequeue(sched->priority_queue);
+		}
 	}
 
 	if (sched->active)
@@ -171,31 +490,948 @@ void SchedClear(scheduler_t *sched)
 
 size_t SchedSize(const scheduler_t *sched)
 {
-	return (PQCount(sched->priority_queue) + (sched->active != NULL));
+	return (QueueCount(sched) + (sched->active != NULL) + sched->in_flight);
 }
 
 int SchedIsEmpty(const scheduler_t *sched)
 {
 	assert(sched);
 	
-	return (PQIsEmpty(sched->priority_queue) && !sched->active);
+	return (QueueIsEmpty(sched) && !sched->active && 0 == sched->in_flight);
 } 
 
+int SchedEnableStats(scheduler_t *sched, int level)
+{
+	assert(sched);
+	assert(!sched->is_running);
+	
+	if (SCHED_STATS_OFF == level)
+	{
+		FreeStats(sched);
+		return SUCCESS;
+	}
+	
+	if (!sched->stats)
+	{
+		sched->stats = CreateRunStats(1);
+		if (!sched->stats)
+		{
+			return ERROR;
+		}
+	}
+	
+	if (SCHED_STATS_PER_TASK == level && !sched->task_stats)
+	{
+		sched->task_stats = UIDMapCreate(0);
+		if (!sched->task_stats)
+		{
+			return ERROR;
+		}
+	}
+	else if (SCHED_STATS_PER_TASK != level && sched->task_stats)
+	{
+		UIDMapForEach(sched->task_stats, DestroyRunStatsAction, NULL);
+		UIDMapDestroy(sched->task_stats);
+		sched->task_stats = NULL;
+	}
+	
+	return SUCCESS;
+}
+
+int SchedGetStats(const scheduler_t *sched, sched_stats_t *stats)
+{
+	assert(sched);
+	assert(stats);
+	
+	if (!sched->stats)
+	{
+		return ERROR;
+	}
+	
+	Summarize(sched->stats->lateness, &stats->lateness_ns);
+	Summarize(sched->stats->duration, &stats->duration_ns);
+	Summarize(sched->stats->depth, &stats->queue_depth);
+	
+	return SUCCESS;
+}
+
+int SchedGetTaskStats(const scheduler_t *sched, ilrd_uid_t task_id, 
+					  sched_stats_t *stats)
+{
+	run_stats_t *task_stats = NULL;
+	
+	assert(sched);
+	assert(stats);
+	
+	if (!sched->task_stats || !UIDMapFind(sched->index, task_id))
+	{
+		return ERROR;
+	}
+	
+	/* A task that hasn't run yet has empty stats */
+	task_stats = UIDMapFind(sched->task_stats, task_id);
+	
+	Summarize(task_stats ? task_stats->lateness : NULL, &stats->lateness_ns);
+	Summarize(task_stats ? task_stats->duration : NULL, &stats->duration_ns);
+	Summarize(NULL, &stats->queue_depth);
+	
+	return SUCCESS;
+}
+
+void SchedResetStats(scheduler_t *sched)
+{
+	assert(sched);
+	
+	if (sched->stats)
+	{
+		HistReset(sched->stats->lateness);
+		HistReset(sched->stats->duration);
+		HistReset(sched->stats->depth);
+	}
+	
+	if (sched->task_stats)
+	{
+		UIDMapForEach(sched->task_stats, DestroyRunStatsAction, NULL);
+		UIDMapClear(sched->task_stats);
+	}
+}
+
 /******************************* Static Functions *****************************/
 
 static int PriorityRule(const void *data, const void *dest_data)
 {
+	struct timespec one = {0};
+	struct timespec other = {0};
+	
 	assert(data);
 	assert(dest_data);
 	
-	return (difftime(TaskGetTimeToRun((task_t *)data), 
-					 TaskGetTimeToRun((task_t *)dest_data)));
+	one = TaskGetDeadline((task_t *)data);
+	other = TaskGetDeadline((task_t *)dest_data);
+	
+	if (one.tv_sec != other.tv_sec)
+	{
+		return (one.tv_sec < other.tv_sec ? -1 : 1);
+	}
+	
+	return ((one.tv_nsec > other.tv_nsec) - (one.tv_nsec < other.tv_nsec));
 }
 
-static int FindToRemove(const void *data, void *param )
+static void UpdateIndex(void *data, size_t index)
 {
+	TaskSetQueueIndex((task_t *)data, index);
+}
+
+static size_t WheelKey(const void *data)
+{
+	struct timespec deadline = {0};
+
 	assert(data);
-	assert(param);
-	
-	return (UIDIsEqual(*(ilrd_uid_t *)data, *(ilrd_uid_t *)param));
-}                 
+
+	deadline = TaskGetDeadline((task_t *)data);
+
+	/* Wheel ticks are milliseconds, round up so a task never runs early */
+	return ((size_t)deadline.tv_sec * (NS_PER_SEC / NS_PER_MS) + 
+			((size_t)deadline.tv_nsec + NS_PER_MS - 1) / NS_PER_MS);
+}
+
+static int DestroyTaskAction(void *data, void *param)
+{
+	(void)param;
+
+	TaskDestroy((task_t *)data);
+
+	return (SUCCESS);
+}
+
+static scheduler_t *AllocSched(void)
+{
+	scheduler_t *sched = (scheduler_t *)malloc(sizeof(scheduler_t));
+	if (!sched)
+	{
+		return NULL;
+	}
+
+	sched->index = UIDMapCreate(0);
+	if (!sched->index)
+	{
+		free(sched);
+		return NULL;
+	}
+
+	sched->submissions = MPSCCreate();
+	if (!sched->submissions)
+	{
+		UIDMapDestroy(sched->index);
+		free(sched);
+		return NULL;
+	}
+
+	sched->priority_queue = NULL;
+	sched->wheel = NULL;
+	sched->active = NULL;
+	sched->workers = NULL;
+	sched->in_flight = 0;
+	sched->run_status = SUCCESS;
+	sched->stats = NULL;
+	sched->task_stats = NULL;
+	sched->watches = NULL;
+	sched->n_watches = 0;
+	atomic_init(&sched->owner, &thread_tag);
+	atomic_init(&sched->is_running, 0);
+	atomic_init(&sched->wake_pending, 0);
+
+	/* Without the event fds the run loop falls back to plain sleeping */
+	if (SUCCESS != InitLoopFds(sched))
+	{
+		sched->epoll_fd = NO_FD;
+		sched->timer_fd = NO_FD;
+		sched->event_fd = NO_FD;
+	}
+
+	return (sched);
+}
+
+static void FreeSched(scheduler_t *sched)
+{
+	assert(sched);
+
+	if (sched->workers)
+	{
+		WPoolDestroy(sched->workers);
+	}
+
+	FreeStats(sched);
+
+	if (NO_FD != sched->epoll_fd)
+	{
+		close(sched->epoll_fd);
+		close(sched->timer_fd);
+		close(sched->event_fd);
+	}
+
+	free(sched->watches);
+	MPSCDestroy(sched->submissions);
+	UIDMapDestroy(sched->index);
+	free(sched);
+}
+
+/*
+	One timerfd armed to the deadline of the head task and one eventfd that
+	is signaled when tasks are added or removed or the scheduler is stopped,
+	both waited on by a single epoll instance
+*/
+static int InitLoopFds(scheduler_t *sched)
+{
+	struct epoll_event event = {0};
+
+	assert(sched);
+
+	sched->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	sched->timer_fd = timerfd_create(CLOCK_MONOTONIC, 
+									 TFD_NONBLOCK | TFD_CLOEXEC);
+	sched->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	if (NO_FD != sched->epoll_fd && NO_FD != sched->timer_fd && 
+		NO_FD != sched->event_fd)
+	{
+		event.events = EPOLLIN;
+		event.data.fd = sched->timer_fd;
+		if (0 == epoll_ctl(sched->epoll_fd, EPOLL_CTL_ADD, sched->timer_fd, 
+						   &event))
+		{
+			event.data.fd = sched->event_fd;
+			if (0 == epoll_ctl(sched->epoll_fd, EPOLL_CTL_ADD, 
+							   sched->event_fd, &event))
+			{
+				return (SUCCESS);
+			}
+		}
+	}
+
+	if (NO_FD != sched->epoll_fd)
+	{
+		close(sched->epoll_fd);
+	}
+
+	if (NO_FD != sched->timer_fd)
+	{
+		close(sched->timer_fd);
+	}
+
+	if (NO_FD != sched->event_fd)
+	{
+		close(sched->event_fd);
+	}
+
+	return (ERROR);
+}
+
+/* Lets a waiting run loop re-evaluate the head of the queue */
+static void Wake(scheduler_t *sched)
+{
+	assert(sched);
+
+	if (sched->is_running && NO_FD != sched->event_fd)
+	{
+		eventfd_write(sched->event_fd, 1);
+	}
+}
+
+/* Destroys a task that is no longer in the queue */
+static void DestroyTask(scheduler_t *sched, task_t *task)
+{
+	assert(sched);
+	assert(task);
+
+	UIDMapRemove(sched->index, TaskGetUID(task));
+	DestroyTaskStats(sched, task);
+	TaskDestroy(task);
+}
+
+/* The thread that created the scheduler, or the one running it, owns it */
+static int IsOwner(const scheduler_t *sched)
+{
+	assert(sched);
+
+	return (&thread_tag == atomic_load(&sched->owner));
+}
+
+/* Posts an add, or a removal when task is NULL, to the owning thread */
+static int Submit(scheduler_t *sched, task_t *task, ilrd_uid_t uid)
+{
+	submission_t *submission = NULL;
+
+	assert(sched);
+
+	submission = (submission_t *)malloc(sizeof(submission_t));
+	if (!submission)
+	{
+		if (task)
+		{
+			TaskDestroy(task);
+		}
+
+		return (ERROR);
+	}
+
+	submission->kind = task ? SUBMIT_ADD : SUBMIT_REMOVE;
+	submission->task = task;
+	submission->uid = uid;
+
+	Post(sched, submission);
+
+	return (SUCCESS);
+}
+
+static void Post(scheduler_t *sched, submission_t *submission)
+{
+	assert(sched);
+	assert(submission);
+
+	MPSCPush(sched->submissions, &submission->node);
+
+	/* One wake up is enough for every submission posted before the drain */
+	if (!atomic_exchange(&sched->wake_pending, 1) && NO_FD != sched->event_fd)
+	{
+		eventfd_write(sched->event_fd, 1);
+	}
+}
+
+/* Applies everything posted by other threads, in the order it was posted */
+static void ApplySubmissions(scheduler_t *sched)
+{
+	submission_t *submission = NULL;
+
+	assert(sched);
+
+	if (!atomic_load_explicit(&sched->wake_pending, memory_order_relaxed))
+	{
+		return;
+	}
+
+	atomic_store(&sched->wake_pending, 0);
+
+	while (NULL != (submission = (submission_t *)
+									MPSCPop(sched->submissions)))
+	{
+		switch (submission->kind)
+		{
+			case SUBMIT_ADD:
+				(void)AddTask(sched, submission->task);
+				break;
+
+			case SUBMIT_REMOVE:
+				(void)RemoveTask(sched, submission->uid);
+				break;
+
+			default:
+				CompleteJob(sched, submission);
+				break;
+		}
+
+		free(submission);
+	}
+}
+
+static int AddTask(scheduler_t *sched, task_t *task)
+{
+	assert(sched);
+	assert(task);
+
+	if (PQENQUEUE_SUCCESS != UIDMapInsert(sched->index, TaskGetUID(task), 
+										  task))
+	{
+		TaskDestroy(task);
+		return (ERROR);
+	}
+	
+	if (PQENQUEUE_SUCCESS != QueuePush(sched, task))
+	{
+		DestroyTask(sched, task);
+		return (ERROR);
+	}
+
+	return (SUCCESS);
+}
+
+static int RemoveTask(scheduler_t *sched, ilrd_uid_t task_id)
+{
+	task_t *removed_task = NULL;
+
+	assert(sched);
+
+	removed_task = UIDMapFind(sched->index, task_id);
+	
+	/* A running task is not in the queue and can't be removed */
+	if (!removed_task || removed_task == sched->active || 
+		TaskIsInFlight(removed_task))
+	{
+		return (ERROR);
+	}
+
+	QueueRemove(sched, removed_task);
+	DestroyTask(sched, removed_task);
+
+	return (SUCCESS);
+}
+
+/* Requeues or destroys a task that has run, returns the status of the run */
+static int FinishTask(scheduler_t *sched, task_t *task, int status)
+{
+	assert(sched);
+	assert(task);
+
+	if (status == REPEAT)
+	{
+		TaskUpdateTimeToRun(task);
+		status = QueuePush(sched, task);
+		
+		if (status == PQENQUEUE_FAIL)
+		{
+			DestroyTask(sched, task);
+		}
+	}
+	else
+	{
+		DestroyTask(sched, task);
+	}
+
+	return (status);
+}
+
+/* Hands every task that is due to the workers */
+static void DispatchDueTasks(scheduler_t *sched)
+{
+	submission_t *job = NULL;
+	task_t *task = NULL;
+
+	assert(sched);
+
+	do
+	{
+		RecordDepth(sched);
+		task = QueuePop(sched);
+
+		job = (submission_t *)malloc(sizeof(submission_t));
+		if (job)
+		{
+			job->kind = SUBMIT_DONE;
+			job->task = task;
+			TaskSetInFlight(task, 1);
+			++sched->in_flight;
+		}
+
+		if (!job || 0 != WPoolSubmit(sched->workers, job))
+		{
+			/* No room to hand it over, run it right here */
+			if (job)
+			{
+				TaskSetInFlight(task, 0);
+				--sched->in_flight;
+				free(job);
+			}
+
+			sched->active = task;
+			sched->run_status = FinishTask(sched, task, RunTask(sched, task));
+			sched->active = NULL;
+		}
+	} while (SUCCESS == sched->run_status && !QueueIsEmpty(sched) && 
+			 IsHeadDue(sched));
+}
+
+/* Runs on a worker thread, the result goes back to the owner */
+static void RunJob(void *job, void *param)
+{
+	submission_t *submission = (submission_t *)job;
+	scheduler_t *sched = (scheduler_t *)param;
+
+	/* Only time the run here, the owner records it */
+	if (sched->stats)
+	{
+		submission->start_ns = NowNs();
+		submission->status = TaskRun(submission->task);
+		submission->end_ns = NowNs();
+	}
+	else
+	{
+		submission->status = TaskRun(submission->task);
+	}
+
+	Post(sched, submission);
+}
+
+static void CompleteJob(scheduler_t *sched, submission_t *submission)
+{
+	int status = SUCCESS;
+
+	assert(sched);
+	assert(submission);
+
+	TaskSetInFlight(submission->task, 0);
+	--sched->in_flight;
+
+	if (sched->stats)
+	{
+		RecordRun(sched, submission->task, submission->start_ns, 
+				  submission->end_ns);
+	}
+
+	status = FinishTask(sched, submission->task, submission->status);
+
+	/* The first task that ends the run decides what SchedRun returns */
+	if (SUCCESS != status && SUCCESS == sched->run_status)
+	{
+		sched->run_status = status;
+	}
+}
+
+static int RunTask(scheduler_t *sched, task_t *task)
+{
+	uint64_t start_ns = 0;
+	int status = SUCCESS;
+
+	assert(sched);
+	assert(task);
+
+	if (!sched->stats)
+	{
+		return (TaskRun(task));
+	}
+
+	start_ns = NowNs();
+	status = TaskRun(task);
+	RecordRun(sched, task, start_ns, NowNs());
+
+	return (status);
+}
+
+/* Records a run, before the deadline of the task moves on */
+static void RecordRun(scheduler_t *sched, task_t *task, uint64_t start_ns, 
+					  uint64_t end_ns)
+{
+	struct timespec deadline = TaskGetDeadline(task);
+	uint64_t deadline_ns = (uint64_t)deadline.tv_sec * NS_PER_SEC + 
+						   (uint64_t)deadline.tv_nsec;
+	uint64_t lateness_ns = start_ns > deadline_ns ? start_ns - deadline_ns : 0;
+	run_stats_t *task_stats = NULL;
+
+	assert(sched);
+	assert(sched->stats);
+
+	HistRecord(sched->stats->lateness, lateness_ns);
+	HistRecord(sched->stats->duration, end_ns - start_ns);
+
+	if (!sched->task_stats)
+	{
+		return;
+	}
+
+	task_stats = UIDMapFind(sched->task_stats, TaskGetUID(task));
+	if (!task_stats)
+	{
+		/* Without memory for it the task just goes without its own stats */
+		task_stats = CreateRunStats(0);
+		if (!task_stats)
+		{
+			return;
+		}
+
+		if (PQENQUEUE_SUCCESS != UIDMapInsert(sched->task_stats, 
+											  TaskGetUID(task), task_stats))
+		{
+			DestroyRunStatsAction(task_stats, NULL);
+			return;
+		}
+	}
+
+	HistRecord(task_stats->lateness, lateness_ns);
+	HistRecord(task_stats->duration, end_ns - start_ns);
+}
+
+/* Records how many tasks are waiting or running as one is about to run */
+static void RecordDepth(scheduler_t *sched)
+{
+	assert(sched);
+
+	if (sched->stats)
+	{
+		HistRecord(sched->stats->depth, QueueCount(sched) + sched->in_flight);
+	}
+}
+
+static run_stats_t *CreateRunStats(int with_depth)
+{
+	run_stats_t *stats = (run_stats_t *)calloc(1, sizeof(run_stats_t));
+	if (!stats)
+	{
+		return (NULL);
+	}
+
+	stats->lateness = HistCreate();
+	stats->duration = HistCreate();
+	if (with_depth)
+	{
+		stats->depth = HistCreate();
+	}
+
+	if (!stats->lateness || !stats->duration || (with_depth && !stats->depth))
+	{
+		DestroyRunStatsAction(stats, NULL);
+		return (NULL);
+	}
+
+	return (stats);
+}
+
+static int DestroyRunStatsAction(void *data, void *param)
+{
+	run_stats_t *stats = (run_stats_t *)data;
+
+	(void)param;
+
+	HistDestroy(stats->lateness);
+	HistDestroy(stats->duration);
+	HistDestroy(stats->depth);
+	free(stats);
+
+	return (SUCCESS);
+}
+
+static void DestroyTaskStats(scheduler_t *sched, const task_t *task)
+{
+	run_stats_t *task_stats = NULL;
+
+	assert(sched);
+	assert(task);
+
+	if (sched->task_stats)
+	{
+		task_stats = UIDMapRemove(sched->task_stats, TaskGetUID(task));
+		if (task_stats)
+		{
+			DestroyRunStatsAction(task_stats, NULL);
+		}
+	}
+}
+
+static void FreeStats(scheduler_t *sched)
+{
+	assert(sched);
+
+	if (sched->task_stats)
+	{
+		UIDMapForEach(sched->task_stats, DestroyRunStatsAction, NULL);
+		UIDMapDestroy(sched->task_stats);
+		sched->task_stats = NULL;
+	}
+
+	if (sched->stats)
+	{
+		DestroyRunStatsAction(sched->stats, NULL);
+		sched->stats = NULL;
+	}
+}
+
+static void Summarize(const hist_t *hist, sched_summary_t *summary)
+{
+	assert(summary);
+
+	if (!hist)
+	{
+		memset(summary, 0, sizeof(sched_summary_t));
+		return;
+	}
+
+	summary->count = HistCount(hist);
+	summary->min = HistMin(hist);
+	summary->max = HistMax(hist);
+	summary->mean = HistMean(hist);
+	summary->p50 = HistPercentile(hist, 50);
+	summary->p90 = HistPercentile(hist, 90);
+	summary->p99 = HistPercentile(hist, 99);
+	summary->p999 = HistPercentile(hist, 99.9);
+}
+
+static int QueuePush(scheduler_t *sched, task_t *task)
+{
+	void *handle = NULL;
+
+	assert(sched);
+	assert(task);
+
+	if (sched->wheel)
+	{
+		handle = TWInsert(sched->wheel, task);
+		TaskSetQueueHandle(task, handle);
+
+		return (NULL == handle ? PQENQUEUE_FAIL : PQENQUEUE_SUCCESS);
+	}
+
+	return (PQEnqueue(sched->priority_queue, task));
+}
+
+static task_t *QueuePop(scheduler_t *sched)
+{
+	assert(sched);
+
+	if (sched->wheel)
+	{
+		return ((task_t *)TWPopExpired(sched->wheel));
+	}
+
+	return ((task_t *)PQDequeue(sched->priority_queue));
+}
+
+static void QueueRemove(scheduler_t *sched, task_t *task)
+{
+	assert(sched);
+	assert(task);
+
+	if (sched->wheel)
+	{
+		TWRemove(sched->wheel, TaskGetQueueHandle(task));
+		return;
+	}
+
+	PQEraseAt(sched->priority_queue, TaskGetQueueIndex(task));
+}
+
+static size_t QueueCount(const scheduler_t *sched)
+{
+	assert(sched);
+
+	if (sched->wheel)
+	{
+		return (TWCount(sched->wheel));
+	}
+
+	return (PQCount(sched->priority_queue));
+}
+
+static int QueueIsEmpty(const scheduler_t *sched)
+{
+	assert(sched);
+
+	if (sched->wheel)
+	{
+		return (TWIsEmpty(sched->wheel));
+	}
+
+	return (PQIsEmpty(sched->priority_queue));
+}
+
+/*
+	Returns 1 if the head of the queue is due. Otherwise sleeps until it is
+	due or until the loop is woken up, and returns 1 only if it is due by then
+*/
+static int WaitForDueTask(scheduler_t *sched)
+{
+	struct timespec deadline;
+
+	assert(sched);
+
+	/* Only the workers hold tasks, wait for one of them to come back */
+	if (QueueIsEmpty(sched))
+	{
+		WaitForEvent(sched, NULL);
+		return (0);
+	}
+
+	if (IsHeadDue(sched))
+	{
+		return (1);
+	}
+
+	deadline = HeadDeadline(sched);
+
+	if (NO_FD == sched->epoll_fd)
+	{
+		SleepUntil(&deadline);
+	}
+	else
+	{
+		WaitForEvent(sched, &deadline);
+	}
+
+	return (IsHeadDue(sched));
+}
+
+static int IsHeadDue(scheduler_t *sched)
+{
+	struct timespec deadline;
+	struct timespec now;
+
+	assert(sched);
+
+	if (sched->wheel)
+	{
+		TWAdvance(sched->wheel, NowMs());
+
+		return (TWNextTick(sched->wheel) == TWNow(sched->wheel));
+	}
+
+	deadline = TaskGetDeadline(PQPeek(sched->priority_queue));
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (deadline.tv_sec < now.tv_sec || 
+		   (deadline.tv_sec == now.tv_sec && deadline.tv_nsec <= now.tv_nsec));
+}
+
+/* The time at which the queue has to be looked at again */
+static struct timespec HeadDeadline(scheduler_t *sched)
+{
+	struct timespec deadline;
+	size_t next_tick = 0;
+
+	assert(sched);
+
+	if (sched->wheel)
+	{
+		next_tick = TWNextTick(sched->wheel);
+
+		deadline.tv_sec = next_tick / (NS_PER_SEC / NS_PER_MS);
+		deadline.tv_nsec = (next_tick % (NS_PER_SEC / NS_PER_MS)) * NS_PER_MS;
+
+		return (deadline);
+	}
+
+	return (TaskGetDeadline(PQPeek(sched->priority_queue)));
+}
+
+static void WaitForEvent(scheduler_t *sched, const struct timespec *deadline)
+{
+	struct itimerspec timer = {0};
+	struct epoll_event events[MAX_EVENTS];
+	uint64_t count = 0;
+	int n_events = 0;
+	int i = 0;
+
+	assert(sched);
+
+	/* Without a deadline the timer is disarmed */
+	if (deadline)
+	{
+		timer.it_value = *deadline;
+	}
+
+	timerfd_settime(sched->timer_fd, TFD_TIMER_ABSTIME, &timer, NULL);
+
+	/* A signal interrupts the wait just like a wake up does */
+	n_events = epoll_wait(sched->epoll_fd, events, MAX_EVENTS, -1);
+
+	/* Drain the loop fds that fired, both are level triggered */
+	for (i = 0; i < n_events; ++i)
+	{
+		if (sched->timer_fd == events[i].data.fd || 
+			sched->event_fd == events[i].data.fd)
+		{
+			(void)read(events[i].data.fd, &count, sizeof(count));
+		}
+		else
+		{
+			RunWatch(sched, events[i].data.fd);
+		}
+	}
+}
+
+/* Runs the action of a watched fd that became readable, the same way a task 
+   is run: anything but REPEAT ends the watch, STOP and ERROR end the run */
+static void RunWatch(scheduler_t *sched, int fd)
+{
+	int status = SUCCESS;
+
+	assert(sched);
+
+	/* Unwatched by an earlier action of the same wait */
+	if ((size_t)fd >= sched->n_watches || !sched->watches[fd].action)
+	{
+		return;
+	}
+
+	status = sched->watches[fd].action(fd, sched->watches[fd].param);
+	if (REPEAT == status)
+	{
+		return;
+	}
+
+	SchedUnwatchFd(sched, fd);
+
+	if (SUCCESS != status && SUCCESS == sched->run_status)
+	{
+		sched->run_status = status;
+	}
+}
+
+static uint64_t NowNs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((uint64_t)now.tv_sec * NS_PER_SEC + (uint64_t)now.tv_nsec);
+}
+
+static size_t NowMs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((size_t)now.tv_sec * (NS_PER_SEC / NS_PER_MS) + 
+			(size_t)now.tv_nsec / NS_PER_MS);
+}
+
+/* Sleeps until the absolute deadline, a signal does not cut the sleep short */
+static void SleepUntil(const struct timespec *deadline)
+{
+	int status = 0;
+
+	assert(deadline);
+
+	do
+	{
+		status = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline, 
+								 NULL);
+	} while (EINTR == status);
+}
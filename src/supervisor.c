@@ -0,0 +1,46 @@
+#define _POSIX_C_SOURCE (200112L)
+
+#include <stdio.h> /* fprintf() */
+#include <stdlib.h> /* EXIT_FAILURE */
+#include <signal.h> /* sigaction() */
+
+#include "wd_supervisor.h"
+
+static wd_supervisor_t *sup = NULL;
+
+static void StopHandler(int sig)
+{
+    (void)sig;
+
+    WDSupervisorStop(sup);
+}
+
+/* Usage: wd_supervisor <socket path>, clients find it in WD_SUPERVISOR */
+int main(int argc, char *argv[])
+{
+    struct sigaction stop = {0};
+    int status = 0;
+
+    if (2 != argc)
+    {
+        fprintf(stderr, "usage: %s <socket path>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    sup = WDSupervisorCreate(argv[1]);
+    if (NULL == sup)
+    {
+        fprintf(stderr, "%s: can't listen on %s\n", argv[0], argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    stop.sa_handler = StopHandler;
+    sigaction(SIGTERM, &stop, NULL);
+    sigaction(SIGINT, &stop, NULL);
+
+    status = WDSupervisorRun(sup);
+
+    WDSupervisorDestroy(sup);
+
+    return status;
+}
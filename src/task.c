@@ -6,13 +6,18 @@
 	Last Updated: Sun 03 Mar 2024 16:37:37 
 */
 
-#include <time.h> /* time_t */
+#include <time.h> /* clock_gettime() */
 #include <stdlib.h> /* malloc() */
 #include <assert.h> /* assert() */
 
 #include "uid.h" /* ilrd_uid_t */
 #include "task.h" /* task_action_func_t */
 
+#define NS_PER_SEC (1000000000UL)
+
+static void AddNs(struct timespec *ts, size_t ns);
+static int IsBefore(const struct timespec *one, const struct timespec *other);
+
 struct task
 {
 	ilrd_uid_t uid;
@@ -20,13 +25,24 @@ struct task
 	task_clean_func_t clean_func;
 	void *action_params;
 	void *cleanup_params;
-	size_t interval;
-	time_t run_time;
+	size_t interval_ns;
+	struct timespec run_time;
+	size_t queue_index;
+	void *queue_handle;
+	int in_flight;
 };
 
 task_t *TaskCreate(size_t interval, task_action_func_t action, 
 				  task_clean_func_t cleanup, 
 				  void *action_params, void *cleanup_params)
+{
+	return (TaskCreateNs(interval * NS_PER_SEC, action, cleanup, 
+						 action_params, cleanup_params));
+}
+
+task_t *TaskCreateNs(size_t interval_ns, task_action_func_t action, 
+					task_clean_func_t cleanup, 
+					void *action_params, void *cleanup_params)
 {
 	task_t *task = NULL;
 	
@@ -51,9 +67,14 @@ task_t *TaskCreate(size_t interval, task_action_func_t action,
 	task->clean_func = cleanup;
 	task->cleanup_params = cleanup_params;
 	
-	task->interval = interval;
+	task->interval_ns = interval_ns;
+	
+	clock_gettime(CLOCK_MONOTONIC, &task->run_time);
+	AddNs(&task->run_time, interval_ns);
 	
-	task->run_time = time(NULL) + interval;
+	task->queue_index = 0;
+	task->queue_handle = NULL;
+	task->in_flight = 0;
 	
 	return (task);
 } 
@@ -101,13 +122,95 @@ time_t TaskGetTimeToRun(const task_t *task)
 {
 	assert(task);
 	
+	return (task->run_time.tv_sec);
+}
+
+struct timespec TaskGetDeadline(const task_t *task)
+{
+	assert(task);
+	
 	return (task->run_time);
 }
 
 void TaskUpdateTimeToRun(task_t *task)
+{
+	struct timespec now;
+	
+	assert(task);
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	
+	/* Keep the period steady, unless whole periods were already missed */
+	AddNs(&task->run_time, task->interval_ns);
+	if (IsBefore(&task->run_time, &now))
+	{
+		task->run_time = now;
+		AddNs(&task->run_time, task->interval_ns);
+	}
+}
+
+void TaskSetQueueIndex(task_t *task, size_t index)
+{
+	assert(task);
+	
+	task->queue_index = index;
+}
+
+size_t TaskGetQueueIndex(const task_t *task)
+{
+	assert(task);
+	
+	return (task->queue_index);
+}
+
+void TaskSetQueueHandle(task_t *task, void *handle)
+{
+	assert(task);
+	
+	task->queue_handle = handle;
+}
+
+void *TaskGetQueueHandle(const task_t *task)
+{
+	assert(task);
+	
+	return (task->queue_handle);
+}
+
+void TaskSetInFlight(task_t *task, int in_flight)
+{
+	assert(task);
+	
+	task->in_flight = in_flight;
+}
+
+int TaskIsInFlight(const task_t *task)
 {
 	assert(task);
 	
-	task->run_time = time(0) + task->interval;
+	return (task->in_flight);
+}
+
+static void AddNs(struct timespec *ts, size_t ns)
+{
+	assert(ts);
+	
+	ts->tv_sec += ns / NS_PER_SEC;
+	ts->tv_nsec += ns % NS_PER_SEC;
+	
+	if (ts->tv_nsec >= (long)NS_PER_SEC)
+	{
+		++ts->tv_sec;
+		ts->tv_nsec -= NS_PER_SEC;
+	}
+}
+
+static int IsBefore(const struct timespec *one, const struct timespec *other)
+{
+	assert(one);
+	assert(other);
+	
+	return (one->tv_sec < other->tv_sec || 
+		   (one->tv_sec == other->tv_sec && one->tv_nsec < other->tv_nsec));
 }
 
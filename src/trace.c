@@ -0,0 +1,134 @@
+/*
+	Name: Guy Feigin
+	Exercise: Watchdog trace reader
+	File Type: Source code
+	Reviewer:
+	Last Updated: Sat 17 Oct 2026 18:55:40
+*/
+
+#define _POSIX_C_SOURCE (200809L) /* O_CLOEXEC */
+
+#include <stdio.h> /* printf() */
+#include <stdlib.h> /* qsort() */
+#include <string.h> /* strncmp() */
+#include <fcntl.h> /* open() */
+#include <unistd.h> /* readlink() */
+#include <dirent.h> /* opendir() */
+#include <limits.h> /* PATH_MAX */
+
+#include "wd_shm.h" /* WDShmGetTrace() */
+
+#define NO_FD (-1)
+#define LINK_SIZE (64)
+#define NS_PER_MS (1e6)
+
+static const char *sides[WD_SIDES] = {"user", "watchdog"};
+static const char *events[WD_EVENTS] = {
+	"start", "beat_sent", "beat_seen", "check", "exited", "hung", "stalled",
+	"backoff", "revive", "gave_up", "stop"
+};
+
+static wd_trace_event_t trace[WD_SIDES * WD_TRACE_EVENTS];
+
+static int OpenPage(const char *pid);
+static int CompareTime(const void *a, const void *b);
+
+/*
+ * Usage: wd_trace <pid>, of either process of a pair. The events of both
+ * sides are printed in time order, those of a process that crashed too,
+ * with the time in milliseconds since the first one. A pair that beats over
+ * signals has no page, and so no trace
+ */
+int main(int argc, char *argv[])
+{
+	wd_shm_t *shm = NULL;
+	size_t n_events = 0;
+	size_t i = 0;
+	int fd = NO_FD;
+
+	if (2 != argc)
+	{
+		fprintf(stderr, "usage: %s <pid>\n", argv[0]);
+		return (EXIT_FAILURE);
+	}
+
+	fd = OpenPage(argv[1]);
+	shm = NO_FD == fd ? NULL : WDShmAttach(fd);
+	if (NULL == shm)
+	{
+		fprintf(stderr, "%s: no watchdog page in process %s\n", argv[0],
+				argv[1]);
+		if (NO_FD != fd)
+		{
+			close(fd);
+		}
+
+		return (EXIT_FAILURE);
+	}
+
+	n_events = WDShmGetTrace(shm, WD_SIDE_USER, trace, WD_TRACE_EVENTS);
+	n_events += WDShmGetTrace(shm, WD_SIDE_WD, trace + n_events,
+							  WD_TRACE_EVENTS);
+	WDShmDetach(shm);
+
+	qsort(trace, n_events, sizeof(trace[0]), CompareTime);
+
+	printf("%12s  %-8s  %7s  %-9s  %s\n", "ms", "side", "pid", "event", "arg");
+	for (i = 0; i < n_events; ++i)
+	{
+		printf("%12.3f  %-8s  %7d  %-9s  %llu\n",
+			   (trace[i].ns - trace[0].ns) / NS_PER_MS, sides[trace[i].side],
+			   (int)trace[i].pid,
+			   trace[i].event < WD_EVENTS ? events[trace[i].event] : "?",
+			   (unsigned long long)trace[i].arg);
+	}
+
+	return (EXIT_SUCCESS);
+}
+
+/*							  Static Functions								  */
+/******************************************************************************/
+
+/* The page is the memory file named "watchdog" among the process' fds */
+static int OpenPage(const char *pid)
+{
+	char path[PATH_MAX] = {0};
+	char link[LINK_SIZE] = {0};
+	struct dirent *entry = NULL;
+	DIR *dir = NULL;
+	ssize_t len = 0;
+	int fd = NO_FD;
+
+	snprintf(path, sizeof(path), "/proc/%s/fd", pid);
+	dir = opendir(path);
+	if (NULL == dir)
+	{
+		return (NO_FD);
+	}
+
+	while (NO_FD == fd && NULL != (entry = readdir(dir)))
+	{
+		snprintf(path, sizeof(path), "/proc/%s/fd/%s", pid, entry->d_name);
+		len = readlink(path, link, sizeof(link) - 1);
+		if (0 < len)
+		{
+			link[len] = '\0';
+			if (0 == strncmp(link, "/memfd:watchdog ", 16))
+			{
+				fd = open(path, O_RDWR | O_CLOEXEC);
+			}
+		}
+	}
+
+	closedir(dir);
+
+	return (fd);
+}
+
+static int CompareTime(const void *a, const void *b)
+{
+	const wd_trace_event_t *first = (const wd_trace_event_t *)a;
+	const wd_trace_event_t *second = (const wd_trace_event_t *)b;
+
+	return ((first->ns > second->ns) - (first->ns < second->ns));
+}
@@ -0,0 +1,535 @@
+/*
+	Name: Guy Feigin
+	Exercise: Timing wheel
+	File type: Source code
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 10:12:04
+*/
+
+#include <stdlib.h> /* malloc() */
+#include <assert.h> /* assert() */
+
+#include "dlist.h" /* dlist_t */
+#include "twheel.h" /* twheel_t */
+
+#define TW_LEVELS (4)
+#define TW_SLOT_BITS (6)
+#define TW_SLOTS (1 << TW_SLOT_BITS)
+#define TW_SLOT_MASK (TW_SLOTS - 1)
+#define TW_NO_TICK ((size_t)-1)
+#define TW_POOL_CHUNK (64)
+
+/* Number of ticks the given level spans, 64^(level + 1) */
+#define TW_LEVEL_SPAN(level) ((size_t)1 << (TW_SLOT_BITS * ((level) + 1)))
+
+enum status
+{
+	FAIL = -1,
+	SUCCESS
+};
+
+struct twheel
+{
+	tw_key_func_t key_func;
+	size_t now;
+	size_t pending;
+	size_t expired_count;
+	dlist_t *slots[TW_LEVELS][TW_SLOTS];
+	dlist_t *overflow;
+	dlist_t *expired;
+	dlist_t *cascade;
+};
+
+static dlist_t *TargetList(twheel_t *tw, size_t tick);
+static void MoveNode(dlist_iter_t node, dlist_t *to);
+static void Place(twheel_t *tw, dlist_iter_t node);
+static void Cascade(twheel_t *tw, dlist_t *slot);
+static void Expire(twheel_t *tw, dlist_t *slot);
+static void Tick(twheel_t *tw);
+static size_t NextLevelTick(const twheel_t *tw, size_t level);
+static void ClearList(dlist_t *list);
+
+/*							  Global Functions								  */
+/******************************************************************************/
+
+twheel_t *TWCreate(tw_key_func_t key_func, size_t now)
+{
+	twheel_t *tw = NULL;
+	dlist_pool_t *pool = NULL;
+	size_t level = 0;
+	size_t slot = 0;
+
+	assert(key_func);
+
+	tw = (twheel_t *)calloc(1, sizeof(twheel_t));
+	if (!tw)
+	{
+		return (NULL);
+	}
+
+	tw->key_func = key_func;
+	tw->now = now;
+
+	/* Elements travel between the slots, so all lists share one pool */
+	pool = DListPoolCreate(TW_POOL_CHUNK);
+	if (!pool)
+	{
+		free(tw);
+		return (NULL);
+	}
+
+	tw->overflow = DListCreateWithPool(pool);
+	tw->expired = DListCreateWithPool(pool);
+	tw->cascade = DListCreateWithPool(pool);
+	if (!tw->overflow || !tw->expired || !tw->cascade)
+	{
+		DListPoolDestroy(pool);
+		TWDestroy(tw);
+		return (NULL);
+	}
+
+	for (level = 0; level < TW_LEVELS; ++level)
+	{
+		for (slot = 0; slot < TW_SLOTS; ++slot)
+		{
+			tw->slots[level][slot] = DListCreateWithPool(pool);
+			if (!tw->slots[level][slot])
+			{
+				DListPoolDestroy(pool);
+				TWDestroy(tw);
+				return (NULL);
+			}
+		}
+	}
+
+	DListPoolDestroy(pool);
+
+	return (tw);
+}
+
+void TWDestroy(twheel_t *tw)
+{
+	size_t level = 0;
+	size_t slot = 0;
+
+	assert(tw);
+
+	for (level = 0; level < TW_LEVELS; ++level)
+	{
+		for (slot = 0; slot < TW_SLOTS; ++slot)
+		{
+			if (tw->slots[level][slot])
+			{
+				DListDestroy(tw->slots[level][slot]);
+			}
+		}
+	}
+
+	if (tw->overflow)
+	{
+		DListDestroy(tw->overflow);
+	}
+
+	if (tw->expired)
+	{
+		DListDestroy(tw->expired);
+	}
+
+	if (tw->cascade)
+	{
+		DListDestroy(tw->cascade);
+	}
+
+	free(tw);
+}
+
+tw_handle_t TWInsert(twheel_t *tw, void *data)
+{
+	size_t tick = 0;
+	dlist_t *target = NULL;
+	dlist_iter_t handle = NULL;
+
+	assert(tw);
+	assert(data);
+
+	tick = tw->key_func(data);
+	target = TargetList(tw, tick);
+
+	handle = DListPushBack(target, data);
+	if (DListIsIterSame(handle, DListEnd(target)))
+	{
+		return (NULL);
+	}
+
+	if (target == tw->expired)
+	{
+		++tw->expired_count;
+	}
+	else
+	{
+		++tw->pending;
+	}
+
+	return (handle);
+}
+
+void *TWRemove(twheel_t *tw, tw_handle_t handle)
+{
+	void *data = NULL;
+
+	assert(tw);
+	assert(handle);
+
+	data = DListGetData(handle);
+
+	/* Every element whose tick is not after now sits in the expired list */
+	if (tw->key_func(data) <= tw->now)
+	{
+		--tw->expired_count;
+	}
+	else
+	{
+		--tw->pending;
+	}
+
+	DListRemove(handle);
+
+	return (data);
+}
+
+void *TWErase(twheel_t *tw, tw_match_func_t match_func, void *param)
+{
+	dlist_iter_t found = NULL;
+	size_t level = 0;
+	size_t slot = 0;
+
+	assert(tw);
+	assert(match_func);
+
+	found = DListFind(DListBegin(tw->expired), DListEnd(tw->expired),
+					  match_func, param);
+	if (!DListIsIterSame(found, DListEnd(tw->expired)))
+	{
+		return (TWRemove(tw, found));
+	}
+
+	for (level = 0; level < TW_LEVELS; ++level)
+	{
+		for (slot = 0; slot < TW_SLOTS; ++slot)
+		{
+			dlist_t *list = tw->slots[level][slot];
+
+			found = DListFind(DListBegin(list), DListEnd(list),
+							  match_func, param);
+			if (!DListIsIterSame(found, DListEnd(list)))
+			{
+				return (TWRemove(tw, found));
+			}
+		}
+	}
+
+	found = DListFind(DListBegin(tw->overflow), DListEnd(tw->overflow),
+					  match_func, param);
+	if (!DListIsIterSame(found, DListEnd(tw->overflow)))
+	{
+		return (TWRemove(tw, found));
+	}
+
+	return (NULL);
+}
+
+void TWAdvance(twheel_t *tw, size_t now)
+{
+	assert(tw);
+
+	while (tw->now < now)
+	{
+		/* Nothing left to cascade or expire, jump straight to now */
+		if (0 == tw->pending)
+		{
+			tw->now = now;
+			break;
+		}
+
+		Tick(tw);
+	}
+}
+
+void *TWPopExpired(twheel_t *tw)
+{
+	assert(tw);
+
+	if (DListIsEmpty(tw->expired))
+	{
+		return (NULL);
+	}
+
+	--tw->expired_count;
+
+	return (DListPopFront(tw->expired));
+}
+
+size_t TWNextTick(const twheel_t *tw)
+{
+	size_t next = TW_NO_TICK;
+	size_t candidate = 0;
+	size_t level = 0;
+
+	assert(tw);
+
+	if (0 != tw->expired_count)
+	{
+		return (tw->now);
+	}
+
+	if (0 == tw->pending)
+	{
+		return (TW_NO_TICK);
+	}
+
+	for (level = 0; level < TW_LEVELS; ++level)
+	{
+		candidate = NextLevelTick(tw, level);
+		if (candidate < next)
+		{
+			next = candidate;
+		}
+	}
+
+	if (!DListIsEmpty(tw->overflow))
+	{
+		candidate = (tw->now | (TW_LEVEL_SPAN(TW_LEVELS - 1) - 1)) + 1;
+		if (candidate < next)
+		{
+			next = candidate;
+		}
+	}
+
+	return (next);
+}
+
+size_t TWNow(const twheel_t *tw)
+{
+	assert(tw);
+
+	return (tw->now);
+}
+
+size_t TWCount(const twheel_t *tw)
+{
+	assert(tw);
+
+	return (tw->pending + tw->expired_count);
+}
+
+int TWIsEmpty(const twheel_t *tw)
+{
+	assert(tw);
+
+	return (0 == TWCount(tw));
+}
+
+int TWForEach(twheel_t *tw, tw_action_func_t action, void *param)
+{
+	int status = SUCCESS;
+	size_t level = 0;
+	size_t slot = 0;
+	dlist_t *list = NULL;
+
+	assert(tw);
+	assert(action);
+
+	status = DListForEach(DListBegin(tw->expired), DListEnd(tw->expired),
+						  action, param);
+
+	for (level = 0; level < TW_LEVELS && SUCCESS == status; ++level)
+	{
+		for (slot = 0; slot < TW_SLOTS && SUCCESS == status; ++slot)
+		{
+			list = tw->slots[level][slot];
+			status = DListForEach(DListBegin(list), DListEnd(list),
+								  action, param);
+		}
+	}
+
+	if (SUCCESS == status)
+	{
+		status = DListForEach(DListBegin(tw->overflow),
+							  DListEnd(tw->overflow), action, param);
+	}
+
+	return (status);
+}
+
+void TWClear(twheel_t *tw)
+{
+	size_t level = 0;
+	size_t slot = 0;
+
+	assert(tw);
+
+	for (level = 0; level < TW_LEVELS; ++level)
+	{
+		for (slot = 0; slot < TW_SLOTS; ++slot)
+		{
+			ClearList(tw->slots[level][slot]);
+		}
+	}
+
+	ClearList(tw->overflow);
+	ClearList(tw->expired);
+
+	tw->pending = 0;
+	tw->expired_count = 0;
+}
+
+/*							  Static Functions								  */
+/******************************************************************************/
+
+static dlist_t *TargetList(twheel_t *tw, size_t tick)
+{
+	size_t delta = 0;
+	size_t level = 0;
+
+	assert(tw);
+
+	if (tick <= tw->now)
+	{
+		return (tw->expired);
+	}
+
+	delta = tick - tw->now;
+
+	for (level = 0; level < TW_LEVELS; ++level)
+	{
+		if (delta < TW_LEVEL_SPAN(level))
+		{
+			return (tw->slots[level]
+					[(tick >> (TW_SLOT_BITS * level)) & TW_SLOT_MASK]);
+		}
+	}
+
+	return (tw->overflow);
+}
+
+/* Relinks a single node to the back of another list, so handles stay valid */
+static void MoveNode(dlist_iter_t node, dlist_t *to)
+{
+	assert(node);
+	assert(to);
+
+	DListSplice(node, DListNext(node), DListEnd(to));
+}
+
+static void Place(twheel_t *tw, dlist_iter_t node)
+{
+	dlist_t *target = NULL;
+
+	assert(tw);
+	assert(node);
+
+	target = TargetList(tw, tw->key_func(DListGetData(node)));
+	if (target == tw->expired)
+	{
+		--tw->pending;
+		++tw->expired_count;
+	}
+
+	MoveNode(node, target);
+}
+
+static void Cascade(twheel_t *tw, dlist_t *slot)
+{
+	assert(tw);
+	assert(slot);
+
+	if (DListIsEmpty(slot))
+	{
+		return;
+	}
+
+	/*
+		Detach the whole slot first, an element of the overflow list may
+		be placed right back into it
+	*/
+	DListSplice(DListBegin(slot), DListEnd(slot), DListEnd(tw->cascade));
+
+	while (!DListIsEmpty(tw->cascade))
+	{
+		Place(tw, DListBegin(tw->cascade));
+	}
+}
+
+static void Expire(twheel_t *tw, dlist_t *slot)
+{
+	assert(tw);
+	assert(slot);
+
+	while (!DListIsEmpty(slot))
+	{
+		--tw->pending;
+		++tw->expired_count;
+
+		MoveNode(DListBegin(slot), tw->expired);
+	}
+}
+
+static void Tick(twheel_t *tw)
+{
+	size_t level = TW_LEVELS;
+	size_t now = 0;
+
+	assert(tw);
+
+	now = ++tw->now;
+
+	if (0 == (now & (TW_LEVEL_SPAN(TW_LEVELS - 1) - 1)))
+	{
+		Cascade(tw, tw->overflow);
+	}
+
+	/* Cascade from the highest level whose lower bits just wrapped */
+	while (--level > 0)
+	{
+		if (0 == (now & (TW_LEVEL_SPAN(level - 1) - 1)))
+		{
+			Cascade(tw, tw->slots[level]
+					[(now >> (TW_SLOT_BITS * level)) & TW_SLOT_MASK]);
+		}
+	}
+
+	Expire(tw, tw->slots[0][now & TW_SLOT_MASK]);
+}
+
+/* 
+ * First tick after now at which a non empty slot of the level is processed.
+ * Above level 0 a slot may hold the block a whole turn ahead, the one that
+ * wraps onto the slot of now itself
+ */
+static size_t NextLevelTick(const twheel_t *tw, size_t level)
+{
+	size_t shift = TW_SLOT_BITS * level;
+	size_t block = tw->now >> shift;
+	size_t last = 0 == level ? TW_SLOTS - 1 : TW_SLOTS;
+	size_t i = 0;
+
+	for (i = 1; i <= last; ++i)
+	{
+		if (!DListIsEmpty(tw->slots[level][(block + i) & TW_SLOT_MASK]))
+		{
+			return ((block + i) << shift);
+		}
+	}
+
+	return (TW_NO_TICK);
+}
+
+static void ClearList(dlist_t *list)
+{
+	assert(list);
+
+	while (!DListIsEmpty(list))
+	{
+		DListPopFront(list);
+	}
+}
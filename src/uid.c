@@ -7,42 +7,67 @@
 */
 
 #include <unistd.h> /* getpid() */
-#include <pthread.h> /* mutex_t */
+#include <pthread.h> /* pthread_once() */
+#include <stdatomic.h> /* atomic_size_t */
 
 #include "uid.h" /* ilrd_uid_t */
 
-pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+#define COMPACT_COUNTER_BITS (42)
+#define COMPACT_COUNTER_MASK (((uint64_t)1 << COMPACT_COUNTER_BITS) - 1)
+
+static void InitPid(void);
+static void RefreshPid(void);
 
 const ilrd_uid_t bad_uid = {0, -1, -1};
 
+static atomic_size_t count = 1;
+static pid_t cached_pid = -1;
+static pthread_once_t pid_once = PTHREAD_ONCE_INIT;
+
 ilrd_uid_t UIDGenerate(void)
 {
 	ilrd_uid_t uid;
-	static size_t count = 1;
-
-	if (0 != pthread_mutex_lock(&mutex))
-	{
-		return (bad_uid);
-	} 
+	struct timespec now;
 
-	uid.counter = count++;
+	pthread_once(&pid_once, InitPid);
 
-	if (0 != pthread_mutex_unlock(&mutex))
-	{
-		return (bad_uid);
-	}
+	uid.counter = atomic_fetch_add_explicit(&count, 1, memory_order_relaxed);
+	uid.pid = cached_pid;
 
-	uid.pid = getpid();
-	uid.time = time(NULL);
-	
-	if (-1 == uid.time || -1 == uid.pid)
+	/* The coarse clock is read from the vdso without a system call */
+	if (0 != clock_gettime(CLOCK_REALTIME_COARSE, &now) || -1 == uid.pid)
 	{
 		return (bad_uid); 
 	}
 
+	uid.time = now.tv_sec;
+
 	return (uid);
 }
 
+uint64_t UIDCompact(ilrd_uid_t uid)
+{
+	return (((uint64_t)uid.pid << COMPACT_COUNTER_BITS) | 
+			((uint64_t)uid.counter & COMPACT_COUNTER_MASK));
+}
+
+size_t UIDHash(ilrd_uid_t uid)
+{
+	size_t hash = uid.counter;
+
+	/* Fold the fields together and mix them with the splitmix64 finalizer */
+	hash ^= (size_t)uid.pid * 0x9E3779B97F4A7C15UL;
+	hash ^= (size_t)uid.time * 0xC2B2AE3D27D4EB4FUL;
+
+	hash ^= hash >> 30;
+	hash *= 0xBF58476D1CE4E5B9UL;
+	hash ^= hash >> 27;
+	hash *= 0x94D049BB133111EBUL;
+	hash ^= hash >> 31;
+
+	return (hash);
+}
+
 int UIDIsEqual(ilrd_uid_t one, ilrd_uid_t other)
 {
 	
@@ -50,3 +75,16 @@ int UIDIsEqual(ilrd_uid_t one, ilrd_uid_t other)
 			one.pid == other.pid && 
 			one.time == other.time);
 }
+
+static void InitPid(void)
+{
+	cached_pid = getpid();
+
+	/* The child of a fork keeps the counter but gets a pid of its own */
+	pthread_atfork(NULL, NULL, RefreshPid);
+}
+
+static void RefreshPid(void)
+{
+	cached_pid = getpid();
+}
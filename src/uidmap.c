@@ -0,0 +1,234 @@
+/*
+	Name: Guy Feigin
+	Exercise: UID map
+	File type: Source code
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 13:05:47
+*/
+
+#include <stdlib.h> /* calloc() */
+#include <assert.h> /* assert() */
+
+#include "uidmap.h" /* uidmap_t */
+
+#define MAP_MIN_CAPACITY (64)
+#define MAP_SUCCESS (0)
+#define MAP_FAIL (1)
+
+typedef struct map_entry
+{
+	ilrd_uid_t uid;
+	void *value;
+} map_entry_t;
+
+struct uidmap
+{
+	map_entry_t *entries;
+	size_t mask;
+	size_t count;
+};
+
+static size_t FindSlot(const uidmap_t *map, ilrd_uid_t uid);
+static int Grow(uidmap_t *map);
+static int IsFull(const uidmap_t *map);
+
+/*							  Global Functions								  */
+/******************************************************************************/
+
+uidmap_t *UIDMapCreate(size_t capacity)
+{
+	uidmap_t *map = NULL;
+	size_t size = MAP_MIN_CAPACITY;
+
+	/* Keep the load below 70% for the expected number of entries */
+	while (size * 7 < capacity * 10)
+	{
+		size *= 2;
+	}
+
+	map = (uidmap_t *)malloc(sizeof(uidmap_t));
+	if (!map)
+	{
+		return (NULL);
+	}
+
+	map->entries = (map_entry_t *)calloc(size, sizeof(map_entry_t));
+	if (!map->entries)
+	{
+		free(map);
+		return (NULL);
+	}
+
+	map->mask = size - 1;
+	map->count = 0;
+
+	return (map);
+}
+
+void UIDMapDestroy(uidmap_t *map)
+{
+	assert(map);
+
+	free(map->entries);
+	free(map);
+}
+
+int UIDMapInsert(uidmap_t *map, ilrd_uid_t uid, void *value)
+{
+	size_t slot = 0;
+
+	assert(map);
+	assert(value);
+
+	if (IsFull(map) && MAP_SUCCESS != Grow(map))
+	{
+		return (MAP_FAIL);
+	}
+
+	slot = FindSlot(map, uid);
+	assert(!map->entries[slot].value);
+
+	map->entries[slot].uid = uid;
+	map->entries[slot].value = value;
+	++map->count;
+
+	return (MAP_SUCCESS);
+}
+
+void *UIDMapFind(const uidmap_t *map, ilrd_uid_t uid)
+{
+	assert(map);
+
+	return (map->entries[FindSlot(map, uid)].value);
+}
+
+void *UIDMapRemove(uidmap_t *map, ilrd_uid_t uid)
+{
+	size_t hole = 0;
+	size_t next = 0;
+	size_t home = 0;
+	void *value = NULL;
+
+	assert(map);
+
+	hole = FindSlot(map, uid);
+	value = map->entries[hole].value;
+	if (!value)
+	{
+		return (NULL);
+	}
+
+	/*
+		Backward shift: move every following entry of the probe run into
+		the hole, unless its home slot lies cyclically after the hole
+	*/
+	next = (hole + 1) & map->mask;
+	while (map->entries[next].value)
+	{
+		home = UIDHash(map->entries[next].uid) & map->mask;
+
+		if (((next - home) & map->mask) >= ((next - hole) & map->mask))
+		{
+			map->entries[hole] = map->entries[next];
+			hole = next;
+		}
+
+		next = (next + 1) & map->mask;
+	}
+
+	map->entries[hole].value = NULL;
+	--map->count;
+
+	return (value);
+}
+
+size_t UIDMapCount(const uidmap_t *map)
+{
+	assert(map);
+
+	return (map->count);
+}
+
+void UIDMapClear(uidmap_t *map)
+{
+	size_t i = 0;
+
+	assert(map);
+
+	for (i = 0; i <= map->mask; ++i)
+	{
+		map->entries[i].value = NULL;
+	}
+
+	map->count = 0;
+}
+
+int UIDMapForEach(const uidmap_t *map, uidmap_action_func_t action, 
+				  void *param)
+{
+	int status = MAP_SUCCESS;
+	size_t i = 0;
+
+	assert(map);
+	assert(action);
+
+	for (i = 0; i <= map->mask && MAP_SUCCESS == status; ++i)
+	{
+		if (map->entries[i].value)
+		{
+			status = action(map->entries[i].value, param);
+		}
+	}
+
+	return (status);
+}
+
+/*							  Static Functions								  */
+/******************************************************************************/
+
+/* Returns the slot holding the uid, or the empty slot that ends its run */
+static size_t FindSlot(const uidmap_t *map, ilrd_uid_t uid)
+{
+	size_t slot = UIDHash(uid) & map->mask;
+
+	while (map->entries[slot].value &&
+		   !UIDIsEqual(map->entries[slot].uid, uid))
+	{
+		slot = (slot + 1) & map->mask;
+	}
+
+	return (slot);
+}
+
+static int Grow(uidmap_t *map)
+{
+	map_entry_t *old_entries = map->entries;
+	size_t old_size = map->mask + 1;
+	size_t i = 0;
+
+	map->entries = (map_entry_t *)calloc(old_size * 2, sizeof(map_entry_t));
+	if (!map->entries)
+	{
+		map->entries = old_entries;
+		return (MAP_FAIL);
+	}
+
+	map->mask = old_size * 2 - 1;
+
+	for (i = 0; i < old_size; ++i)
+	{
+		if (old_entries[i].value)
+		{
+			map->entries[FindSlot(map, old_entries[i].uid)] = old_entries[i];
+		}
+	}
+
+	free(old_entries);
+
+	return (MAP_SUCCESS);
+}
+
+static int IsFull(const uidmap_t *map)
+{
+	return ((map->count + 1) * 10 > (map->mask + 1) * 7);
+}
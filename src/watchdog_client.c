@@ -6,75 +6,188 @@
     Reviewer: Hila Cohen 
 */
 #define _POSIX_C_SOURCE (200112L)
+#define _XOPEN_SOURCE (700) /* realpath() */
 
 #include <pthread.h> /* pthread_create() */
-#include <unistd.h> /* fork() */
-#include <stdio.h> /* printf() */
+#include <unistd.h> /* getppid() */
+#include <stdio.h> /* snprintf() */
 #include <string.h> /* strcmp */
 #include <signal.h> /* sigaction */
 #include <stdlib.h> /* getenv() */
 #include <stdatomic.h> /* atomic_int */
 #include <semaphore.h> /* semopen() */
 #include <fcntl.h> 
+#include <limits.h> /* PATH_MAX */
+#include <errno.h> /* ESRCH */
+#include <time.h> /* clock_gettime() */
+#include <sys/wait.h> /* waitpid() */
+#include <sys/pidfd.h> /* pidfd_open() */
+#include <sys/prctl.h> /* prctl() */
+#include <sys/socket.h> /* socketpair() */
 
 #include "scheduler.h" /* schedcreate() */  
-
-#ifndef DNDEBUG
-    #define DEBUG_EXPR(x) (x) 
-#else
-    #define DEBUG_EXPR(x) 
-#endif
+#include "watchdog_client.h" /* wd_config_t */
+#include "wd_shm.h" /* WDShmBeat() */
+#include "wd_phi.h" /* WDPhiIsSuspect() */
+#include "wd_spawn.h" /* WDSpawn() */
+#include "wd_supervisor.h" /* WDSupervisorRegister() */
 
 #define FAIL_FACTOR (5)
+#define HEARTBEAT_MS (1000)
+#define STOP_POLL_MS (2000)
+#define RESTART_BUDGET (5)
+#define RESTART_WINDOW_MS (60000)
+#define BACKOFF_MS (1000)
+#define BACKOFF_MAX_MS (30000)
+#define FALSE_POSITIVE_PPM (1)
 
 atomic_int alive_counter = 0;
 atomic_int stop_flag = 0;
+atomic_int peer_stopping = 0;
+atomic_int wd_state = WD_STATE_OFF;
  
 pid_t other_pid = 0;
+int peer_fd = -1;
+int supervisor_fd = -1;
+pid_t standby_pid = 0;
+char wd_exec[PATH_MAX] = {0};
+char user_exec[PATH_MAX] = {0};
+int link_fd = -1;
+int standby_link = -1;
+int state_fd = -1;
+int recovered_fd = -1;
+int listen_fds[WD_LISTEN_MAX] = {0};
+size_t n_listen = 0;
+int listen_loaded = 0;
+pthread_mutex_t link_lock = PTHREAD_MUTEX_INITIALIZER;
+
 pthread_t scheduler_thread = 0;
-const char *curr_proccess = NULL;
 scheduler_t *sched = NULL;
-sem_t *sem_user = NULL;
-sem_t *sem_wd = NULL;
-
-typedef enum wd_status
-{
-    WD_SUCCESS = 0,
-    WD_FAILURE
-} wd_status_t;
+sem_t *sems[WD_SIDES] = {NULL, NULL};
+char sem_names[WD_SIDES][32] = {{0}};
+wd_shm_t *shm = NULL;
+wd_side_t self_side = WD_SIDE_USER;
+wd_side_t peer_side = WD_SIDE_WD;
+uint64_t peer_seq = 0;
+wd_phi_t *detector = NULL;
+wd_config_t config = {HEARTBEAT_MS, FAIL_FACTOR, STOP_POLL_MS, 0, 
+                      RESTART_BUDGET, RESTART_WINDOW_MS, BACKOFF_MS, 
+                      BACKOFF_MAX_MS, FALSE_POSITIVE_PPM};
+wd_restart_policy_t restart_policy = {RESTART_BUDGET, RESTART_WINDOW_MS, 
+                                      BACKOFF_MS, BACKOFF_MAX_MS};
 
 /* Init functions */
 static scheduler_t *InitSched(const char **cmd);
 static void InitSignalHandlers();
 static wd_status_t InitSem();
+static void InitShm();
+static wd_status_t InitExecs(const char **cmd);
+static void InitLink();
+static void LoadListenFds();
+static void CloseListenFds();
+static wd_status_t InitConfig(const wd_config_t *cfg);
+static wd_status_t StartSupervised(const char **cmd);
+static void StopSupervised();
 
 /* Helper functions */
 static void *RunSched(void *arg);
 static void SyncSchedulers();
-static wd_status_t Fork(const char *to_exec, const char **cmd);
+static void PostSide(wd_side_t side);
+static int WaitSide(wd_side_t side, unsigned long wait_ms);
+static wd_status_t Spawn(const char *path, char *const argv[], int link, 
+                         pid_t *pid);
 static wd_status_t CreateThread();
 static wd_status_t Revive(const char **cmd);
+static int Restart(const char **cmd, wd_cause_t cause);
 static void DestroySem();
 static wd_status_t SetEnv();
+static void WatchPeer(const char **cmd);
+static int IsPeerGone();
+static void ReapPeer();
+static void KillPeer();
+static void SpawnStandby(const char **cmd);
+static wd_status_t PromoteStandby();
+static void StopStandby();
+static void ParkStandby();
+static void DumpPhase(int fd, const wd_incident_t *incident, wd_phase_t from, 
+                      wd_phase_t to);
+static int OpenLink(int *child_link);
+static void SetLink(int fd);
+static wd_status_t SendState(int fd);
+static ssize_t RecvState(int fd, int *state);
+static void Trace(wd_event_t event, uint64_t arg);
 
 /* Tasks */
-static int SendSig1(void *param);
+static int SendBeat(void *param);
 static int CheckCounter(void *param);
-static int SendSig2(void *param);
+static int CheckStop(void *param);
+static int ReviveLater(void *param);
+
+/* Watched fds */
+static int PeerDied(int fd, void *param);
+static int LinkReadable(int fd, void *param);
 
 /* Signal handlers */
 static void AliveSignalHandler(int sig, siginfo_t *info, void *uncontext);
 static void StopHandler(int sig, siginfo_t *info, void *uncontext);
 
 wd_status_t WDStart(const char **cmd)
+{
+    return (WDStartEx(cmd, NULL));
+}
+
+wd_status_t WDStartEx(const char **cmd, const wd_config_t *cfg)
 {
     wd_status_t status = 0;
+    int child_link = -1;
+
+    if (0 == strcmp(*cmd, "./watchdog"))
+    {
+        self_side = WD_SIDE_WD;
+        peer_side = WD_SIDE_USER;
+    }
+
+    status = InitConfig(cfg);
+    if (WD_FAILURE == status)
+    {
+        return (status);
+    }
 
-    curr_proccess = cmd[0];
+    /* A shared supervisor replaces the watchdog process of our own */
+    if (WD_SIDE_USER == self_side && NULL != getenv("WD_SUPERVISOR"))
+    {
+        return (StartSupervised(cmd));
+    }
+
+    status = InitExecs(cmd);
+    if (WD_FAILURE == status)
+    {
+        return (status);
+    }
+
+    InitShm();
+
+    /* A standby waits here, initialized, until the watchdog needs it */
+    if (WD_SIDE_USER == self_side && NULL != getenv("WD_STANDBY"))
+    {
+        ParkStandby();
+    }
+
+    /* Tells whoever revived us how long exec and init took */
+    if (NULL != shm)
+    {
+        WDShmMarkIncident(shm, self_side, WD_PHASE_STARTED);
+    }
 
+    InitLink();
+    LoadListenFds();
     InitSem();
 
-    InitSignalHandlers();
+    /* Signals are only the fallback for when there's no shared page */
+    if (NULL == shm)
+    {
+        InitSignalHandlers();
+    }
 
     sched = InitSched(cmd);
     if (NULL == sched)
@@ -82,17 +195,22 @@ wd_status_t WDStart(const char **cmd)
         return (status);
     }
 
+    atomic_store(&wd_state, WD_STATE_ACTIVE);
+
     if (0 == strcmp(*cmd, "./watchdog"))
     {
-        DEBUG_EXPR(printf("Inside WD process | pid: %d\n", getpid()));
-
         other_pid = getppid();
+        Trace(WD_EVENT_START, other_pid);
+        WatchPeer(cmd);
+        SetLink(link_fd);
 
         status = SetEnv();
         if (WD_FAILURE == status)
         {
             return (status);
         }
+
+        SpawnStandby(cmd);
         
         RunSched(sched);
     }
@@ -100,7 +218,9 @@ wd_status_t WDStart(const char **cmd)
     {
         if (!getenv("WD_PID"))
         {
-            status = Fork("./watchdog", cmd);
+            SetLink(OpenLink(&child_link));
+            status = Spawn(wd_exec, (char **)cmd[1], child_link, &other_pid);
+            close(child_link);
             if (WD_FAILURE == status)
             {
                 return (status);
@@ -111,7 +231,8 @@ wd_status_t WDStart(const char **cmd)
             other_pid = atoi(getenv("WD_PID"));
         }
 
-        DEBUG_EXPR(printf("Inside thread\n"));
+        WatchPeer(cmd);
+        Trace(WD_EVENT_START, other_pid);
 
         status = CreateThread();
         if (WD_FAILURE == status)
@@ -125,14 +246,237 @@ wd_status_t WDStart(const char **cmd)
 
 void WDStop(void)
 {
-    kill(other_pid, SIGUSR2);
+    int state = WD_STATE_OFF;
+
+    if (-1 != supervisor_fd)
+    {
+        StopSupervised();
+        return;
+    }
+
+    /* The watchdog is about to exit, it mustn't be revived */
+    atomic_exchange(&peer_stopping, 1);
+    state = atomic_exchange(&wd_state, WD_STATE_OFF);
+
+    if (WD_STATE_ACTIVE == state)
+    {
+        if (NULL != shm)
+        {
+            WDShmStop(shm, WD_SIDE_WD);
+        }
+        else
+        {
+            kill(other_pid, SIGUSR2);
+        }
+
+        /* It answers within a stop poll, unless it died or hangs */
+        WaitSide(WD_SIDE_USER, config.stop_poll_ms + 
+                               config.heartbeat_ms * config.miss_threshold);
+    }
+
+    /* Given up on, the scheduler already stopped on its own */
+    if (WD_STATE_GAVE_UP != state)
+    {
+        SchedStop(sched);
+    }
 
-    sem_wait(sem_user);
-    SchedStop(sched);
     unsetenv("WD_PID");
     DestroySem();
 
     pthread_join(scheduler_thread, NULL);
+
+    /* The watchdog exits right after it let us go, if it's our child */
+    if (WD_STATE_ACTIVE == state)
+    {
+        waitpid(other_pid, NULL, 0);
+    }
+
+    if (-1 != peer_fd)
+    {
+        close(peer_fd);
+        peer_fd = -1;
+    }
+
+    pthread_mutex_lock(&link_lock);
+    SetLink(-1);
+    if (-1 != state_fd)
+    {
+        close(state_fd);
+        state_fd = -1;
+    }
+
+    if (-1 != recovered_fd)
+    {
+        close(recovered_fd);
+        recovered_fd = -1;
+    }
+
+    CloseListenFds();
+    pthread_mutex_unlock(&link_lock);
+
+    unsetenv("WD_SHM_FD");
+    unsetenv("WD_CONFIG");
+    /* The semaphores of the page go away along with it */
+    WDShmDetach(shm);
+    shm = NULL;
+    WDPhiDestroy(detector);
+    detector = NULL;
+}
+
+wd_status_t WDRegisterState(int fd)
+{
+    wd_status_t status = WD_FAILURE;
+    int dup_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+
+    if (-1 == dup_fd)
+    {
+        return (WD_FAILURE);
+    }
+
+    /* Kept, to hand over again to a watchdog revived from now on */
+    pthread_mutex_lock(&link_lock);
+    if (-1 != state_fd)
+    {
+        close(state_fd);
+    }
+
+    state_fd = dup_fd;
+    status = SendState(link_fd);
+    pthread_mutex_unlock(&link_lock);
+
+    return (status);
+}
+
+int WDGetRecoveredState(void)
+{
+    int fd = -1;
+
+    pthread_mutex_lock(&link_lock);
+    fd = recovered_fd;
+    recovered_fd = -1;
+    pthread_mutex_unlock(&link_lock);
+
+    return (fd);
+}
+
+wd_status_t WDRegisterListenFds(const int *fds, size_t n)
+{
+    int dup_fds[WD_LISTEN_MAX] = {0};
+    size_t i = 0;
+
+    if (WD_LISTEN_MAX < n)
+    {
+        return (WD_FAILURE);
+    }
+
+    for (i = 0; i < n; ++i)
+    {
+        dup_fds[i] = fcntl(fds[i], F_DUPFD_CLOEXEC, 0);
+        if (-1 == dup_fds[i])
+        {
+            while (0 < i)
+            {
+                close(dup_fds[--i]);
+            }
+
+            return (WD_FAILURE);
+        }
+    }
+
+    /* Replaces the sockets inherited from the process this one replaces */
+    pthread_mutex_lock(&link_lock);
+    LoadListenFds();
+    CloseListenFds();
+    memcpy(listen_fds, dup_fds, n * sizeof(int));
+    n_listen = n;
+    pthread_mutex_unlock(&link_lock);
+
+    return (WD_SUCCESS);
+}
+
+size_t WDGetListenFds(int *fds, size_t max)
+{
+    size_t n = 0;
+
+    pthread_mutex_lock(&link_lock);
+    LoadListenFds();
+    for (n = 0; n < n_listen && n < max; ++n)
+    {
+        fds[n] = fcntl(listen_fds[n], F_DUPFD_CLOEXEC, 0);
+        if (-1 == fds[n])
+        {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&link_lock);
+
+    return (n);
+}
+
+wd_state_t WDGetState(void)
+{
+    return ((wd_state_t)atomic_load(&wd_state));
+}
+
+size_t WDGetIncidents(wd_incident_t *incidents, size_t max)
+{
+    if (NULL == shm)
+    {
+        return (0);
+    }
+
+    return (WDShmGetIncidents(shm, incidents, max));
+}
+
+void WDDumpIncidents(int fd)
+{
+    static const char *sides[] = {"user", "watchdog"};
+    static const char *causes[] = {"exited", "hung", "stalled"};
+    wd_incident_t incidents[WD_INCIDENTS];
+    size_t n_incidents = WDGetIncidents(incidents, WD_INCIDENTS);
+    size_t i = 0;
+
+    dprintf(fd, "%-9s %-8s %8s %10s %10s %10s %10s %10s\n", "side", "cause", 
+            "pid", "detect_ms", "spawn_ms", "start_ms", "sync_ms", 
+            "total_ms");
+
+    for (i = 0; i < n_incidents; ++i)
+    {
+        dprintf(fd, "%-9s %-8s %8d", sides[incidents[i].side], 
+                causes[incidents[i].cause], (int)incidents[i].pid);
+        DumpPhase(fd, &incidents[i], WD_PHASE_LAST_SEEN, WD_PHASE_DECLARED);
+        DumpPhase(fd, &incidents[i], WD_PHASE_DECLARED, WD_PHASE_SPAWNED);
+        DumpPhase(fd, &incidents[i], WD_PHASE_SPAWNED, WD_PHASE_STARTED);
+        DumpPhase(fd, &incidents[i], WD_PHASE_STARTED, WD_PHASE_SYNCED);
+        DumpPhase(fd, &incidents[i], WD_PHASE_LAST_SEEN, WD_PHASE_SYNCED);
+        dprintf(fd, "\n");
+    }
+}
+
+int WDRegisterThread(unsigned long timeout_ms)
+{
+    if (NULL == shm || 0 == timeout_ms)
+    {
+        return (-1);
+    }
+
+    return (WDShmClaimThread(shm, timeout_ms));
+}
+
+void WDKick(int id)
+{
+    if (NULL != shm && -1 != id)
+    {
+        WDShmKick(shm, id);
+    }
+}
+
+void WDUnregisterThread(int id)
+{
+    if (NULL != shm && -1 != id)
+    {
+        WDShmReleaseThread(shm, id);
+    }
 }
 
 /******************************************************************************/
@@ -146,29 +490,28 @@ static scheduler_t *InitSched(const char **cmd)
     sched = SchedCreate(); 
     if (NULL == sched)
     {
-        DEBUG_EXPR(printf("SchedCreate failed\n"));
         return (NULL);
     }
 
-    uid = SchedAddTask(sched, 1, SendSig1, NULL, NULL, NULL);
+    uid = SchedAddTaskMs(sched, config.heartbeat_ms, SendBeat, NULL, NULL, 
+                         NULL);
     if (UIDIsEqual(uid, bad_uid))
     {
-        DEBUG_EXPR(printf("SchedAddTask 1 failed\n"));
         SchedDestroy(sched);
         return (NULL);
     }
-    uid = SchedAddTask(sched, 1, CheckCounter, cmd, NULL, NULL);
+    uid = SchedAddTaskMs(sched, config.heartbeat_ms, CheckCounter, cmd, NULL, 
+                         NULL);
     if (UIDIsEqual(uid, bad_uid))
     {
-        DEBUG_EXPR(printf("SchedAddTask 2 failed\n"));
         SchedDestroy(sched);
         return (NULL);
     }
 
-    uid = SchedAddTask(sched, 2, SendSig2, sched, NULL, NULL);
+    uid = SchedAddTaskMs(sched, config.stop_poll_ms, CheckStop, sched, NULL, 
+                         NULL);
     if (UIDIsEqual(uid, bad_uid))
     {
-        DEBUG_EXPR(printf("SchedAddTask 3 failed\n"));
         SchedDestroy(sched);
         return (NULL);
     }  
@@ -176,25 +519,237 @@ static scheduler_t *InitSched(const char **cmd)
     return (sched); 
 }
 
+/* 
+ * The sides hand shake over the semaphores of the shared page. Without one,
+ * over named semaphores unique to the pair: named after the first user
+ * process, which leaves its pid in WD_SEM for the rest of the pair
+ */
 static wd_status_t InitSem()
 {
-    sem_user = sem_open("/user_sem", O_CREAT, 0666, 0);
-    if (SEM_FAILED == sem_user)
+    char pair_str[20] = {0};
+    const char *pair = getenv("WD_SEM");
+    int side = 0;
+
+    if (NULL != shm)
+    {
+        return (WD_SUCCESS);
+    }
+
+    if (NULL == pair)
+    {
+        snprintf(pair_str, sizeof(pair_str), "%d", getpid());
+        if (0 != setenv("WD_SEM", pair_str, 1))
+        {
+            return (WD_FAILURE);
+        }
+
+        pair = pair_str;
+    }
+
+    snprintf(sem_names[WD_SIDE_USER], sizeof(sem_names[0]), "/wd_user.%s", 
+             pair);
+    snprintf(sem_names[WD_SIDE_WD], sizeof(sem_names[0]), "/wd_wd.%s", pair);
+
+    for (side = 0; side < WD_SIDES; ++side)
+    {
+        /* Left over by an earlier pair that had the same pid */
+        if (pair == pair_str)
+        {
+            sem_unlink(sem_names[side]);
+        }
+
+        sems[side] = sem_open(sem_names[side], O_CREAT, 0600, 0);
+        if (SEM_FAILED == sems[side])
+        {
+            sems[side] = NULL;
+            return (WD_FAILURE);
+        }
+    }
+
+    return (WD_SUCCESS);
+}
+
+/* 
+ * The user side creates the page and leaves its descriptor in the
+ * environment, so the watchdog and every process revived from then on
+ * inherit both. Without a page the heartbeat falls back to signals
+ */
+static void InitShm()
+{
+    char fd_str[20] = {0};
+    const char *env = getenv("WD_SHM_FD");
+
+    if (NULL != env)
+    {
+        shm = WDShmAttach(atoi(env));
+    }
+    else if (WD_SIDE_USER == self_side)
+    {
+        shm = WDShmCreate();
+        snprintf(fd_str, sizeof(fd_str), "%d", shm ? WDShmGetFd(shm) : -1);
+
+        if (NULL != shm && 0 != setenv("WD_SHM_FD", fd_str, 1))
+        {
+            WDShmDetach(shm);
+            shm = NULL;
+        }
+    }
+
+    if (NULL == shm)
+    {
+        return;
+    }
+
+    peer_seq = WDShmGetBeat(shm, peer_side, NULL);
+
+    /* Beats on the page carry their time, which the detector learns from */
+    detector = WDPhiCreate(config.heartbeat_ms, config.false_positive_ppm);
+}
+
+/* 
+ * The user side passes its config on to the watchdog in WD_CONFIG, and the
+ * watchdog to every process it revives. A config given to WDStartEx wins,
+ * fields left 0 keep their defaults
+ */
+static wd_status_t InitConfig(const wd_config_t *cfg)
+{
+    char config_str[192] = {0};
+    const char *env = getenv("WD_CONFIG");
+
+    if (NULL != cfg)
+    {
+        config = *cfg;
+    }
+    else if (NULL != env)
+    {
+        sscanf(env, "%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu", 
+               &config.heartbeat_ms, &config.miss_threshold, 
+               &config.stop_poll_ms, &config.warm_standby, 
+               &config.restart_budget, &config.restart_window_ms, 
+               &config.backoff_ms, &config.backoff_max_ms, 
+               &config.false_positive_ppm);
+    }
+
+    config.heartbeat_ms = config.heartbeat_ms ? config.heartbeat_ms 
+                                              : HEARTBEAT_MS;
+    config.miss_threshold = config.miss_threshold ? config.miss_threshold 
+                                                  : FAIL_FACTOR;
+    config.stop_poll_ms = config.stop_poll_ms ? config.stop_poll_ms 
+                                              : STOP_POLL_MS;
+    config.restart_budget = config.restart_budget ? config.restart_budget 
+                                                  : RESTART_BUDGET;
+    config.restart_window_ms = config.restart_window_ms 
+                               ? config.restart_window_ms : RESTART_WINDOW_MS;
+    config.backoff_ms = config.backoff_ms ? config.backoff_ms : BACKOFF_MS;
+    config.backoff_max_ms = config.backoff_max_ms ? config.backoff_max_ms 
+                                                  : BACKOFF_MAX_MS;
+    config.false_positive_ppm = config.false_positive_ppm 
+                                ? config.false_positive_ppm 
+                                : FALSE_POSITIVE_PPM;
+
+    restart_policy.budget = config.restart_budget;
+    restart_policy.window_ms = config.restart_window_ms;
+    restart_policy.backoff_ms = config.backoff_ms;
+    restart_policy.backoff_max_ms = config.backoff_max_ms;
+
+    snprintf(config_str, sizeof(config_str), 
+             "%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu", 
+             config.heartbeat_ms, config.miss_threshold, config.stop_poll_ms, 
+             config.warm_standby, config.restart_budget, 
+             config.restart_window_ms, config.backoff_ms, 
+             config.backoff_max_ms, config.false_positive_ppm);
+
+    if (0 != setenv("WD_CONFIG", config_str, 1))
     {
-        DEBUG_EXPR(printf("user sem_open failed\n"));
         return (WD_FAILURE);
     }
 
-    sem_wd = sem_open("/wd_sem", O_CREAT, 0666, 0);
-    if (SEM_FAILED == sem_wd)
+    return (WD_SUCCESS);
+}
+
+/* 
+ * Both executables are looked up once, so a revive is a single posix_spawn
+ * that doesn't depend on the working directory or PATH anymore
+ */
+static wd_status_t InitExecs(const char **cmd)
+{
+    if (0 != WDSpawnResolve("./watchdog", wd_exec) || 
+        0 != WDSpawnResolve(((char **)cmd[1])[0], user_exec))
     {
-        DEBUG_EXPR(printf("wd sem_open failed\n"));
         return (WD_FAILURE);
     }
 
     return (WD_SUCCESS);
 }
 
+/* 
+ * A revived process finds its end of the link to the other side in
+ * WD_LINK, with the state of the process it replaces already waiting in it
+ */
+static void InitLink()
+{
+    const char *env = getenv("WD_LINK");
+
+    if (NULL == env)
+    {
+        return;
+    }
+
+    link_fd = atoi(env);
+    fcntl(link_fd, F_SETFD, FD_CLOEXEC);
+    unsetenv("WD_LINK");
+
+    if (WD_SIDE_USER == self_side && 0 < RecvState(link_fd, &recovered_fd) && 
+        -1 != recovered_fd)
+    {
+        /* Protected as it is, until the process registers another one */
+        state_fd = fcntl(recovered_fd, F_DUPFD_CLOEXEC, 0);
+    }
+}
+
+/* 
+ * The listening sockets of the pair are inherited by every process it
+ * spawns, listed in WD_LISTEN_FDS. Read once, before or at WDStart
+ */
+static void LoadListenFds()
+{
+    const char *env = getenv("WD_LISTEN_FDS");
+    char *end = NULL;
+    long fd = 0;
+
+    if (listen_loaded)
+    {
+        return;
+    }
+
+    listen_loaded = 1;
+    while (NULL != env && '\0' != *env && n_listen < WD_LISTEN_MAX)
+    {
+        fd = strtol(env, &end, 10);
+        if (end == env)
+        {
+            break;
+        }
+
+        if (0 == fcntl((int)fd, F_SETFD, FD_CLOEXEC))
+        {
+            listen_fds[n_listen++] = (int)fd;
+        }
+
+        env = (',' == *end) ? end + 1 : end;
+    }
+
+    unsetenv("WD_LISTEN_FDS");
+}
+
+static void CloseListenFds()
+{
+    while (0 < n_listen)
+    {
+        close(listen_fds[--n_listen]);
+    }
+}
+
 static void InitSignalHandlers()
 {
     struct sigaction alive = {0};
@@ -209,11 +764,80 @@ static void InitSignalHandlers()
     sigaction(SIGUSR2, &stop, NULL);
 }
 
+/* 
+ * Under a supervisor only the beat runs here. The supervisor has our page
+ * and command line, and is the one to revive us
+ */
+static wd_status_t StartSupervised(const char **cmd)
+{
+    ilrd_uid_t uid;
+
+    InitShm();
+    if (NULL == shm)
+    {
+        return (WD_FAILURE);
+    }
+
+    WDShmMarkIncident(shm, self_side, WD_PHASE_STARTED);
+
+    sched = SchedCreate();
+    if (NULL == sched)
+    {
+        return (WD_FAILURE);
+    }
+
+    uid = SchedAddTaskMs(sched, config.heartbeat_ms, SendBeat, NULL, NULL, 
+                         NULL);
+    if (UIDIsEqual(uid, bad_uid))
+    {
+        SchedDestroy(sched);
+        return (WD_FAILURE);
+    }
+
+    supervisor_fd = WDSupervisorRegister(getenv("WD_SUPERVISOR"), 
+                                         WDShmGetFd(shm), (char **)cmd[1], 
+                                         config.heartbeat_ms, 
+                                         config.miss_threshold, 
+                                         config.false_positive_ppm, 
+                                         &restart_policy);
+    if (-1 == supervisor_fd)
+    {
+        SchedDestroy(sched);
+        return (WD_FAILURE);
+    }
+
+    atomic_store(&wd_state, WD_STATE_ACTIVE);
+
+    return (CreateThread());
+}
+
+/* Asking to stop before hanging up tells the supervisor not to revive us */
+static void StopSupervised()
+{
+    WDShmStop(shm, WD_SIDE_WD);
+    close(supervisor_fd);
+    supervisor_fd = -1;
+
+    SchedStop(sched);
+    pthread_join(scheduler_thread, NULL);
+
+    unsetenv("WD_SHM_FD");
+    unsetenv("WD_CONFIG");
+    WDShmDetach(shm);
+    shm = NULL;
+    WDPhiDestroy(detector);
+    detector = NULL;
+}
+
 static void *RunSched(void *arg)
 {
     (void)arg;
 
-    SyncSchedulers();
+    /* A supervisor has no scheduler of its own to sync with */
+    if (-1 == supervisor_fd)
+    {
+        SyncSchedulers();
+    }
 
     SchedRun(sched);
     
@@ -226,29 +850,47 @@ static void *RunSched(void *arg)
 /************************* Helper functions ***********************************/
 /******************************************************************************/
 
-static wd_status_t Fork(const char *to_exec, const char **cmd)
+/* 
+ * The end of a link is passed on in WD_LINK and the listening sockets in
+ * WD_LISTEN_FDS, in an environment of its own since other threads may be
+ * reading ours
+ */
+static wd_status_t Spawn(const char *path, char *const argv[], int link, 
+                         pid_t *pid)
 {
-    int status = 0;
+    char link_env[32] = {0};
+    char listen_env[32 + WD_LISTEN_MAX * 12] = "WD_LISTEN_FDS=";
+    size_t env_len = strlen(listen_env);
+    char *env[3] = {NULL, NULL, NULL};
+    int fds[WD_LISTEN_MAX + 1] = {0};
+    size_t n_fds = 0;
+    size_t n_env = 0;
+    size_t i = 0;
+
+    if (-1 != link)
+    {
+        snprintf(link_env, sizeof(link_env), "WD_LINK=%d", link);
+        env[n_env++] = link_env;
+        fds[n_fds++] = link;
+    }
 
-    pid_t child_pid = fork();
+    /* The kernel keeps queueing connections on them while we're down */
+    for (i = 0; i < n_listen; ++i)
+    {
+        env_len += snprintf(listen_env + env_len, sizeof(listen_env) - env_len,
+                            0 == i ? "%d" : ",%d", listen_fds[i]);
+        fds[n_fds++] = listen_fds[i];
+    }
 
-    if (-1 == child_pid)
+    if (0 < n_listen)
     {
-        DEBUG_EXPR(printf("fork failed\n"));
-        return (WD_FAILURE);
+        env[n_env++] = listen_env;
     }
 
-    if (0 == child_pid)
+    if (0 != WDSpawn(pid, path, argv, NULL, fds, n_fds, env))
     {
-        status = execvp(to_exec, (char * const *)cmd);
-        if (WD_SUCCESS != status)
-        {
-            DEBUG_EXPR(printf("execlp failed\n"));
-            return (WD_FAILURE);
-        }
+        return (WD_FAILURE);
     }
-    
-    other_pid = child_pid;
 
     return (WD_SUCCESS);
 }
@@ -260,7 +902,6 @@ static wd_status_t CreateThread()
     status = pthread_create(&scheduler_thread, NULL, RunSched, NULL);
     if (0 != status)
     {
-        DEBUG_EXPR(printf("pthread_create failed\n"));
         return (WD_FAILURE);
     }
 
@@ -269,67 +910,371 @@ static wd_status_t CreateThread()
 
 static wd_status_t Revive(const char **cmd)
 {
+    wd_status_t status = WD_SUCCESS;
+    int child_link = -1;
     pid_t pid = 0;
-    
-    pid = fork();
-    if (-1 == pid)
+
+    /* The threads of a user process that's gone aren't watched anymore */
+    if (WD_SIDE_WD == self_side && NULL != shm)
     {
-        return (WD_FAILURE);
+        WDShmResetThreads(shm);
     }
 
-    if (0 == pid)
+    /* A late post from a sync that timed out would pass for the new one's */
+    while (0 == WaitSide(self_side, 0))
     {
-        if (0 == strcmp(*cmd, "./watchdog"))
-        {
-            DEBUG_EXPR(printf("%s\n", ((char **)cmd[1])[0]));
+    }
 
-            execvp(((char **)cmd[1])[0], (char **)cmd[1]);
+    /* Stamped first, the new process may get to WDStart before we return */
+    if (NULL != shm)
+    {
+        WDShmMarkIncident(shm, peer_side, WD_PHASE_SPAWNED);
+    }
+    
+    /* A standby is already past exec and its own initialization */
+    if (0 != standby_pid && WD_SUCCESS == PromoteStandby())
+    {
+        pid = standby_pid;
+        standby_pid = 0;
+    }
+    else
+    {
+        /* The state is in the link before the new process can look for it */
+        pthread_mutex_lock(&link_lock);
+        SetLink(OpenLink(&child_link));
+        SendState(link_fd);
+        status = Spawn(WD_SIDE_WD == self_side ? user_exec : wd_exec, 
+                       (char **)cmd[1], child_link, &pid);
+        close(child_link);
+        pthread_mutex_unlock(&link_lock);
 
-            DEBUG_EXPR(printf("execvp failed\n"));
+        if (WD_FAILURE == status)
+        {
             return (WD_FAILURE);
         }
-
-        execvp("./watchdog", (char **)cmd[1]);
-        DEBUG_EXPR(printf("execvp failed\n"));
-        return (WD_FAILURE);
     }
 
     other_pid = pid;
+    WatchPeer(cmd);
+    Trace(WD_EVENT_REVIVE, pid);
 
     SyncSchedulers();
 
+    /* Beats missed during a backoff aren't the new process' */
+    atomic_exchange(&alive_counter, 0);
+    if (NULL != detector)
+    {
+        WDPhiReset(detector);
+    }
+
+    if (NULL != shm)
+    {
+        WDShmMarkIncident(shm, peer_side, WD_PHASE_SYNCED);
+    }
+
+    /* Only once the process is back, the new standby mustn't slow it down */
+    SpawnStandby(cmd);
+
     return (WD_SUCCESS);
 }
 
-static void DestroySem()
+/* 
+ * Revives the other process right away, unless it died too often lately:
+ * then it's revived by a task once a delay is over, or given up on once it
+ * spent its budget. Returns the status for the task or watch calling it
+ */
+static int Restart(const char **cmd, wd_cause_t cause)
 {
-    int status = 0;
-    
-    status = sem_unlink("/user_sem");
-    if (0 != status)
+    long delay_ms = 0;
+    int active = WD_STATE_ACTIVE;
+    ilrd_uid_t uid;
+
+    atomic_exchange(&alive_counter, 0);
+
+    /* Over signals there's nowhere the count would survive us */
+    if (NULL != shm)
     {
-        DEBUG_EXPR(printf("unlink user_sem failed\n"));
+        WDShmOpenIncident(shm, peer_side, cause, other_pid);
+        delay_ms = WDShmRestartDelay(shm, peer_side, &restart_policy);
     }
 
-    status = sem_unlink("/wd_sem");
-    if (0 != status)
+    if (0 == delay_ms)
     {
-        DEBUG_EXPR(printf("unlink wd_sem failed\n"));
+        return (WD_SUCCESS == Revive(cmd) ? REPEAT : ERROR);
     }
 
-    status = sem_close(sem_user);
-    if (0 != status)
+    /* Nothing to watch until the next process is up */
+    if (-1 != peer_fd)
     {
-        DEBUG_EXPR(printf("close user_sem failed\n"));
+        SchedUnwatchFd(sched, peer_fd);
+        close(peer_fd);
+        peer_fd = -1;
     }
 
-    status = sem_close(sem_wd);
-    if (0 != status)
+    /* A failed compare means WDStop came first and takes it from here */
+    if (WD_GIVE_UP == delay_ms)
+    {
+        Trace(WD_EVENT_GAVE_UP, 0);
+        if (!atomic_compare_exchange_strong(&wd_state, &active, 
+                                            WD_STATE_GAVE_UP))
+        {
+            return (REPEAT);
+        }
+
+        StopStandby();
+
+        return (STOP);
+    }
+
+    Trace(WD_EVENT_BACKOFF, (uint64_t)delay_ms);
+    if (!atomic_compare_exchange_strong(&wd_state, &active, WD_STATE_BACKOFF))
+    {
+        return (REPEAT);
+    }
+
+    uid = SchedAddTaskMs(sched, (size_t)delay_ms, ReviveLater, cmd, NULL, NULL);
+
+    return (UIDIsEqual(uid, bad_uid) ? ERROR : REPEAT);
+}
+
+/* 
+ * The watchdog starts the user process once more, to run up to WDStart and
+ * park on the gate of the shared page, see ParkStandby
+ */
+static void SpawnStandby(const char **cmd)
+{
+    int child_link = -1;
+    pid_t pid = 0;
+
+    if (WD_SIDE_WD != self_side || !config.warm_standby || NULL == shm)
+    {
+        return;
+    }
+
+    /* The watchdog has a single thread, the variable is there for the spawn */
+    standby_link = OpenLink(&child_link);
+    if (0 == setenv("WD_STANDBY", "1", 1) && 
+        WD_SUCCESS == Spawn(user_exec, (char **)cmd[1], child_link, &pid))
+    {
+        standby_pid = pid;
+    }
+
+    unsetenv("WD_STANDBY");
+    close(child_link);
+}
+
+static wd_status_t PromoteStandby()
+{
+    if (standby_pid == waitpid(standby_pid, NULL, WNOHANG) || 
+        0 != kill(standby_pid, 0))
+    {
+        StopStandby();
+        return (WD_FAILURE);
+    }
+
+    /* Its link becomes the one to the user process */
+    SendState(standby_link);
+    SetLink(standby_link);
+    standby_link = -1;
+
+    WDShmGateOpen(shm);
+
+    return (WD_SUCCESS);
+}
+
+static void StopStandby()
+{
+    if (0 != standby_pid)
+    {
+        kill(standby_pid, SIGKILL);
+        waitpid(standby_pid, NULL, 0);
+        standby_pid = 0;
+    }
+
+    if (-1 != standby_link)
+    {
+        close(standby_link);
+        standby_link = -1;
+    }
+}
+
+/* Let through, the standby carries on as a revived user process would */
+static void ParkStandby()
+{
+    const char *watchdog = getenv("WD_PID");
+
+    unsetenv("WD_STANDBY");
+
+    /* Parked, it's of no use without the watchdog that started it */
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (NULL == watchdog || getppid() != atoi(watchdog))
+    {
+        _exit(EXIT_FAILURE);
+    }
+
+    if (NULL != shm)
+    {
+        WDShmGateWait(shm);
+    }
+
+    /* From now on it's the one to revive the watchdog when it dies */
+    prctl(PR_SET_PDEATHSIG, 0);
+}
+
+/* How long one phase to another took, if the incident got that far */
+static void DumpPhase(int fd, const wd_incident_t *incident, wd_phase_t from, 
+                      wd_phase_t to)
+{
+    if (0 == incident->phase_ns[from] || 0 == incident->phase_ns[to])
+    {
+        dprintf(fd, " %10s", "-");
+        return;
+    }
+
+    dprintf(fd, " %10.3f", (double)(int64_t)(incident->phase_ns[to] - 
+                                              incident->phase_ns[from]) / 
+                           1000000);
+}
+
+/* Returns our end of a new link, -1 on failure */
+static int OpenLink(int *child_link)
+{
+    int ends[2] = {-1, -1};
+
+    if (0 != socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, ends))
+    {
+        *child_link = -1;
+        return (-1);
+    }
+
+    *child_link = ends[1];
+
+    return (ends[0]);
+}
+
+/* The watchdog watches its link for the states the user process registers */
+static void SetLink(int fd)
+{
+    if (-1 != link_fd && fd != link_fd)
+    {
+        if (WD_SIDE_WD == self_side)
+        {
+            SchedUnwatchFd(sched, link_fd);
+        }
+
+        close(link_fd);
+    }
+
+    link_fd = fd;
+
+    /* If it can't be watched, the state just isn't handed off */
+    if (-1 != link_fd && WD_SIDE_WD == self_side)
     {
-        DEBUG_EXPR(printf("close wd_sem failed\n"));
+        SchedWatchFd(sched, link_fd, LinkReadable, NULL);
     }
 }
 
+/* Passes our reference to the state on, if there's one to pass */
+static wd_status_t SendState(int fd)
+{
+    char control[CMSG_SPACE(sizeof(int))] = {0};
+    struct msghdr msg = {0};
+    struct cmsghdr *cmsg = NULL;
+    struct iovec iov;
+    char byte = 0;
+
+    if (-1 == fd)
+    {
+        return (WD_FAILURE);
+    }
+
+    if (-1 == state_fd)
+    {
+        return (WD_SUCCESS);
+    }
+
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &state_fd, sizeof(int));
+
+    return (1 == sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT) ? WD_SUCCESS 
+                                                               : WD_FAILURE);
+}
+
+/* 
+ * Returns what recvmsg did, with state set to the descriptor that came
+ * along, or -1
+ */
+static ssize_t RecvState(int fd, int *state)
+{
+    char control[CMSG_SPACE(sizeof(int))] = {0};
+    struct msghdr msg = {0};
+    struct cmsghdr *cmsg = NULL;
+    struct iovec iov;
+    char byte = 0;
+    ssize_t n_read = 0;
+
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    *state = -1;
+    n_read = recvmsg(fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    if (0 < n_read && NULL != cmsg && SCM_RIGHTS == cmsg->cmsg_type)
+    {
+        memcpy(state, CMSG_DATA(cmsg), sizeof(int));
+    }
+
+    return (n_read);
+}
+
+/* 
+ * Cheap enough for every tick. The trace lives on the page, so over signals
+ * nothing is traced
+ */
+static void Trace(wd_event_t event, uint64_t arg)
+{
+    if (NULL != shm)
+    {
+        WDShmTrace(shm, self_side, event, arg);
+    }
+}
+
+/* Nothing to do about a failure, the pair is going away anyway */
+static void DestroySem()
+{
+    int side = 0;
+
+    for (side = 0; side < WD_SIDES; ++side)
+    {
+        if (NULL == sems[side])
+        {
+            continue;
+        }
+
+        sem_unlink(sem_names[side]);
+        sem_close(sems[side]);
+
+        sems[side] = NULL;
+    }
+
+    unsetenv("WD_SEM");
+}
+
 static wd_status_t SetEnv()
 {
     pid_t pid = 0;
@@ -341,67 +1286,195 @@ static wd_status_t SetEnv()
 
     if (0 != setenv("WD_PID", pid_str, 1)) 
     {
-        DEBUG_EXPR(printf("Error setting environment variable\n"));
         return (WD_FAILURE);
     }
 
     return (WD_SUCCESS);
 }
 
+/* 
+ * A pidfd becomes readable the moment the other process exits, so a crash
+ * is handled right away. Without one, CheckCounter polls for it instead
+ */
+static void WatchPeer(const char **cmd)
+{
+    if (-1 != peer_fd)
+    {
+        SchedUnwatchFd(sched, peer_fd);
+        close(peer_fd);
+    }
+
+    peer_fd = pidfd_open(other_pid, 0);
+    if (-1 == peer_fd)
+    {
+        return;
+    }
+
+    if (SUCCESS != SchedWatchFd(sched, peer_fd, PeerDied, cmd))
+    {
+        close(peer_fd);
+        peer_fd = -1;
+    }
+}
+
+/* The other process is either our child, or our parent or its child */
+static int IsPeerGone()
+{
+    return (other_pid == waitpid(other_pid, NULL, WNOHANG) || 
+            (0 != kill(other_pid, 0) && ESRCH == errno));
+}
+
+/* Collects the other process if it's our child, so it leaves no zombie */
+static void ReapPeer()
+{
+    waitpid(other_pid, NULL, WNOHANG);
+}
+
+/* A hung process would go on running next to the one that replaces it */
+static void KillPeer()
+{
+    kill(other_pid, SIGKILL);
+    waitpid(other_pid, NULL, 0);
+}
+
+/* 
+ * A process that dies before it gets to sync would hold us up for good.
+ * Past the time a hang takes to be noticed we go on, and find it dead
+ */
 static void SyncSchedulers()
 {
-    if (0 == strcmp(curr_proccess, "./watchdog"))
+    PostSide(peer_side);
+    WaitSide(self_side, config.heartbeat_ms * config.miss_threshold);
+}
+
+static void PostSide(wd_side_t side)
+{
+    if (NULL != shm)
     {
-        sem_post(sem_user);
-        sem_wait(sem_wd);
+        WDShmPost(shm, side);
     }
     else
     {
-        sem_post(sem_wd);
-        sem_wait(sem_user);
+        sem_post(sems[side]);
+    }
+}
+
+/* Returns 0 once the other side posted, 1 if it timed out */
+static int WaitSide(wd_side_t side, unsigned long wait_ms)
+{
+    struct timespec deadline = {0};
+
+    if (NULL != shm)
+    {
+        return (WDShmWait(shm, side, wait_ms));
     }
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += wait_ms / 1000 + 
+                       (deadline.tv_nsec + (wait_ms % 1000) * 1000000) / 
+                       1000000000;
+    deadline.tv_nsec = (deadline.tv_nsec + (wait_ms % 1000) * 1000000) % 
+                       1000000000;
+
+    while (0 != sem_timedwait(sems[side], &deadline))
+    {
+        if (EINTR != errno)
+        {
+            return (1);
+        }
+    }
+
+    return (0);
 }
 
 /******************************************************************************/
 /********************************** Tasks *************************************/
 /******************************************************************************/
 
-static int SendSig1(void *param)
+static int SendBeat(void *param)
 {
     (void)param;
     atomic_fetch_add(&alive_counter, 1);
-    DEBUG_EXPR(printf("Task1 | Send SIG1 from %d\n", getpid()));
-    kill(other_pid, SIGUSR1);
+
+    if (NULL != shm)
+    {
+        WDShmBeat(shm, self_side);
+        Trace(WD_EVENT_BEAT_SENT, WDShmGetBeat(shm, self_side, NULL));
+    }
+    else
+    {
+        kill(other_pid, SIGUSR1);
+    }
 
     return (REPEAT);
 }
 
 static int CheckCounter(void *param)
 {
-    DEBUG_EXPR(printf("Task2 | PID: %d | Counter: %d\n", getpid(), alive_counter));
-    if (alive_counter > FAIL_FACTOR)
+    uint64_t seq = 0;
+    uint64_t beat_ns = 0;
+    int stalled = -1;
+
+    /* A new beat of the other side does what its SIGUSR1 would */
+    if (NULL != shm)
     {
-        DEBUG_EXPR(printf("Other process died\n"));
-        atomic_exchange(&alive_counter, 0);
-        if (WD_FAILURE == Revive(param))
+        seq = WDShmGetBeat(shm, peer_side, &beat_ns);
+        if (seq != peer_seq)
         {
-            return (ERROR);
+            peer_seq = seq;
+            atomic_exchange(&alive_counter, 0);
+            Trace(WD_EVENT_BEAT_SEEN, seq);
+            if (NULL != detector)
+            {
+                WDPhiBeat(detector, seq, beat_ns);
+            }
         }
     }
 
+    Trace(WD_EVENT_CHECK, (uint64_t)atomic_load(&alive_counter));
+    if (peer_stopping || WD_STATE_ACTIVE != atomic_load(&wd_state))
+    {
+        return (REPEAT);
+    }
+
+    /* Exits are caught by the pidfd, counting beats is left for hangs */
+    if (-1 == peer_fd && IsPeerGone())
+    {
+        Trace(WD_EVENT_EXITED, other_pid);
+        return (Restart(param, WD_CAUSE_EXITED));
+    }
+    /* 
+     * The detector catches a hang as soon as the jitter seen so far allows,
+     * the count of missed beats is only the upper bound
+     */
+    else if ((unsigned long)alive_counter > config.miss_threshold || 
+             (NULL != detector && WDPhiIsSuspect(detector)))
+    {
+        Trace(WD_EVENT_HUNG, other_pid);
+        KillPeer();
+        return (Restart(param, WD_CAUSE_HUNG));
+    }
+    /* The user process beats, yet one of its watched threads is stuck */
+    else if (WD_SIDE_WD == self_side && NULL != shm && 
+             -1 != (stalled = WDShmFindStalled(shm)))
+    {
+        Trace(WD_EVENT_STALLED, (uint64_t)stalled);
+        KillPeer();
+        return (Restart(param, WD_CAUSE_STALLED));
+    }
+
     return (REPEAT);
 }
 
-static int SendSig2(void *param)
+static int CheckStop(void *param)
 {
     (void)param;
 
-    DEBUG_EXPR(printf("PID: %d | Task3\n", getpid()));
-
-    if (1 == stop_flag)
+    if (1 == stop_flag || (NULL != shm && WDShmIsStopped(shm, self_side)))
     {
-        DEBUG_EXPR(printf("SIG2 received from pid: %d\n", other_pid));
-        sem_post(sem_user);
+        Trace(WD_EVENT_STOP, 0);
+        StopStandby();
+        PostSide(WD_SIDE_USER);
         SchedStop(sched);
 
         return(STOP); 
@@ -410,6 +1483,66 @@ static int SendSig2(void *param)
     return (REPEAT);
 }
 
+/* The delay of a restart is over, unless WDStop came in the meantime */
+static int ReviveLater(void *param)
+{
+    int backoff = WD_STATE_BACKOFF;
+
+    if (!atomic_compare_exchange_strong(&wd_state, &backoff, WD_STATE_ACTIVE))
+    {
+        return (SUCCESS);
+    }
+
+    return (WD_SUCCESS == Revive(param) ? SUCCESS : ERROR);
+}
+
+/******************************************************************************/
+/******************************** Watched fds *********************************/
+/******************************************************************************/
+
+static int PeerDied(int fd, void *param)
+{
+    (void)fd;
+
+    if (peer_stopping)
+    {
+        return (SUCCESS);
+    }
+
+    Trace(WD_EVENT_EXITED, other_pid);
+    ReapPeer();
+
+    /* Revive watches the new process in place of this one */
+    return (Restart(param, WD_CAUSE_EXITED));
+}
+
+/* The user process registered a new state, it replaces the one we hold */
+static int LinkReadable(int fd, void *param)
+{
+    int received = -1;
+    ssize_t n_read = RecvState(fd, &received);
+
+    (void)param;
+
+    if (0 < n_read || (0 > n_read && (EAGAIN == errno || EINTR == errno)))
+    {
+        if (-1 != received)
+        {
+            if (-1 != state_fd)
+            {
+                close(state_fd);
+            }
+
+            state_fd = received;
+        }
+
+        return (REPEAT);
+    }
+
+    /* Closed by a user process that's gone, its revive opens a new link */
+    return (SUCCESS);
+}
+
 /******************************************************************************/
 /****************************** Signal Handlers *******************************/
 /******************************************************************************/
@@ -419,8 +1552,6 @@ static void AliveSignalHandler(int sig, siginfo_t *info, void *uncontext)
     (void)sig;
     (void)uncontext;
 
-    DEBUG_EXPR(printf("SIGUSR1 received in pid: %d from: %d\n", getpid(), info->si_pid));
-
     if (other_pid == info->si_pid)
     {
         atomic_exchange(&alive_counter, 0);
@@ -431,8 +1562,6 @@ static void StopHandler(int sig, siginfo_t *info, void *uncontext)
 {
     (void)sig;
     (void)uncontext;
-    DEBUG_EXPR(printf("SIGUSR2 received in pid: %d from: %d\n", getpid(), info->si_pid));
-
     if (other_pid == info->si_pid)
     {
         atomic_exchange(&stop_flag, 1);
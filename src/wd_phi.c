@@ -0,0 +1,165 @@
+/*
+	Name: Guy Feigin
+	Exercise: Phi accrual failure detector
+	File type: Source code
+	Reviewer:
+	Last updated: Sun 18 Oct 2026 01:20:06
+*/
+
+#include <stdlib.h> /* calloc() */
+#include <assert.h> /* assert() */
+#include <math.h> /* erfc() */
+#include <time.h> /* clock_gettime() */
+
+#include "wd_phi.h" /* wd_phi_t */
+
+#define NS_PER_MS (1000000UL)
+#define NS_PER_SEC (1000000000UL)
+#define MIN_SAMPLES (8)
+#define MIN_STD_DIV (4)
+#define PPM (1e6)
+#define SQRT2 (1.41421356237309504880)
+
+struct wd_phi
+{
+	double intervals[WD_PHI_WINDOW]; /* In nanoseconds */
+	size_t count;
+	size_t next;
+	double mean;
+	double std;
+	double min_std;
+	double threshold; /* phi of the false positive rate */
+	uint64_t last_seq;
+	uint64_t last_ns;
+};
+
+static void UpdateStats(wd_phi_t *phi);
+static uint64_t NowNs(void);
+
+/******************************************************************************/
+
+wd_phi_t *WDPhiCreate(unsigned long heartbeat_ms, 
+					  unsigned long false_positive_ppm)
+{
+	wd_phi_t *phi = NULL;
+
+	assert(0 < heartbeat_ms);
+	assert(0 < false_positive_ppm);
+
+	phi = (wd_phi_t *)calloc(1, sizeof(wd_phi_t));
+	if (NULL == phi)
+	{
+		return (NULL);
+	}
+
+	phi->min_std = (double)heartbeat_ms * NS_PER_MS / MIN_STD_DIV;
+	phi->threshold = -log10(false_positive_ppm / PPM);
+
+	return (phi);
+}
+
+void WDPhiDestroy(wd_phi_t *phi)
+{
+	free(phi);
+}
+
+void WDPhiReset(wd_phi_t *phi)
+{
+	assert(phi);
+
+	phi->count = 0;
+	phi->next = 0;
+	phi->last_seq = 0;
+	phi->last_ns = 0;
+}
+
+void WDPhiBeat(wd_phi_t *phi, uint64_t seq, uint64_t beat_ns)
+{
+	assert(phi);
+
+	if (seq == phi->last_seq)
+	{
+		return;
+	}
+
+	/* The first beat only starts the first interval */
+	if (0 != phi->last_ns && beat_ns > phi->last_ns && seq > phi->last_seq)
+	{
+		phi->intervals[phi->next] = (double)(beat_ns - phi->last_ns) / 
+									(double)(seq - phi->last_seq);
+		phi->next = (phi->next + 1) % WD_PHI_WINDOW;
+		if (WD_PHI_WINDOW > phi->count)
+		{
+			++phi->count;
+		}
+
+		UpdateStats(phi);
+	}
+
+	phi->last_seq = seq;
+	phi->last_ns = beat_ns;
+}
+
+double WDPhiGet(const wd_phi_t *phi)
+{
+	uint64_t now = NowNs();
+	double since = 0;
+	double p_later = 0;
+
+	assert(phi);
+
+	if (MIN_SAMPLES > phi->count)
+	{
+		return (0);
+	}
+
+	/* The chance that a beat still comes, under a normal distribution */
+	since = now > phi->last_ns ? (double)(now - phi->last_ns) : 0;
+	p_later = 0.5 * erfc((since - phi->mean) / (phi->std * SQRT2));
+
+	return (0 < p_later ? -log10(p_later) : HUGE_VAL);
+}
+
+int WDPhiIsSuspect(const wd_phi_t *phi)
+{
+	return (WDPhiGet(phi) > phi->threshold);
+}
+
+/******************************************************************************/
+
+/* Recomputed from the whole window, so no error builds up over time */
+static void UpdateStats(wd_phi_t *phi)
+{
+	double sum = 0;
+	double sum_sq = 0;
+	double diff = 0;
+	size_t i = 0;
+
+	for (i = 0; i < phi->count; ++i)
+	{
+		sum += phi->intervals[i];
+	}
+
+	phi->mean = sum / phi->count;
+
+	for (i = 0; i < phi->count; ++i)
+	{
+		diff = phi->intervals[i] - phi->mean;
+		sum_sq += diff * diff;
+	}
+
+	phi->std = sqrt(sum_sq / phi->count);
+	if (phi->std < phi->min_std)
+	{
+		phi->std = phi->min_std;
+	}
+}
+
+static uint64_t NowNs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((uint64_t)now.tv_sec * NS_PER_SEC + (uint64_t)now.tv_nsec);
+}
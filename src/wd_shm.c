@@ -0,0 +1,601 @@
+/*
+	Name: Guy Feigin
+	Exercise: Watchdog shared page
+	File type: Source code
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 22:05:13
+*/
+
+#define _GNU_SOURCE /* memfd_create(), sem_clockwait() */
+
+#include <stdlib.h> /* malloc(), rand_r() */
+#include <assert.h> /* assert() */
+#include <stdatomic.h> /* atomic_uint_fast64_t */
+#include <time.h> /* clock_gettime() */
+#include <errno.h> /* EINTR */
+#include <semaphore.h> /* sem_t */
+#include <unistd.h> /* ftruncate() */
+#include <sys/mman.h> /* mmap() */
+
+#include "wd_shm.h" /* wd_shm_t */
+
+#define CACHE_LINE (64)
+
+/* Each side writes only to its own slot, a line apart from the other one */
+typedef struct side_slot
+{
+	_Alignas(CACHE_LINE) _Atomic uint64_t seq;
+	_Atomic uint64_t beat_ns;
+	atomic_int stop;
+	/* Written only by the one that revives the side */
+	uint64_t window_ns;
+	unsigned long restarts;
+	atomic_int incident; /* 1 + index of the revive in progress, or 0 */
+} side_slot_t;
+
+/* Phases are stamped by whichever process gets to them, 0 until then */
+typedef struct incident_slot
+{
+	_Atomic uint64_t phase_ns[WD_PHASES];
+	atomic_int side;
+	atomic_int cause;
+	atomic_int pid;
+} incident_slot_t;
+
+/* 
+ * A thread of the user side owns a slot from claim to release, and is the
+ * only one to write its kicks. The checking side keeps what it last saw in
+ * the same slot, so a revived checker carries on where the last one stopped
+ */
+typedef struct thread_slot
+{
+	_Alignas(CACHE_LINE) _Atomic uint64_t kicks;
+	_Atomic uint64_t timeout_ns; /* 0 while the slot isn't armed */
+	atomic_int used;
+	uint64_t seen_kicks;
+	uint64_t seen_ns;
+} thread_slot_t;
+
+/* 
+ * Written as a seqlock: seq is 0 while the slot is being written, then the
+ * index of the event plus 1. A reader that sees the same seq before and
+ * after copying the slot has a whole event
+ */
+typedef struct trace_slot
+{
+	_Atomic uint64_t seq;
+	_Atomic uint64_t ns;
+	_Atomic uint64_t arg;
+	atomic_int pid;
+	atomic_int event;
+} trace_slot_t;
+
+/* Any thread or signal handler of the side takes the next slot */
+typedef struct trace_ring
+{
+	_Alignas(CACHE_LINE) _Atomic uint64_t head;
+	trace_slot_t slots[WD_TRACE_EVENTS];
+} trace_ring_t;
+
+typedef struct page
+{
+	side_slot_t sides[WD_SIDES];
+	thread_slot_t threads[WD_THREADS];
+	_Atomic uint64_t n_incidents;
+	incident_slot_t incidents[WD_INCIDENTS];
+	sem_t gate;
+	sem_t wake[WD_SIDES]; /* Posted by one side to the other */
+	trace_ring_t traces[WD_SIDES];
+} page_t;
+
+struct wd_shm
+{
+	int fd;
+	pid_t pid; /* Of the process that attached, for its trace events */
+	page_t *page;
+};
+
+static uint64_t NowNs(void);
+static void ReleaseThread(thread_slot_t *slot);
+
+/*							  Global Functions								  */
+/******************************************************************************/
+
+wd_shm_t *WDShmCreate(void)
+{
+	wd_shm_t *shm = NULL;
+	int fd = memfd_create("watchdog", 0);
+	if (-1 == fd)
+	{
+		return (NULL);
+	}
+
+	/* A new memory file reads as zeros, which is a fresh page */
+	if (0 != ftruncate(fd, sizeof(page_t)))
+	{
+		close(fd);
+		return (NULL);
+	}
+
+	shm = WDShmAttach(fd);
+	if (!shm)
+	{
+		close(fd);
+		return (NULL);
+	}
+
+	/* Shared between processes, and initialized only by the creator */
+	if (0 != sem_init(&shm->page->gate, 1, 0) ||
+		0 != sem_init(&shm->page->wake[WD_SIDE_USER], 1, 0) ||
+		0 != sem_init(&shm->page->wake[WD_SIDE_WD], 1, 0))
+	{
+		WDShmDetach(shm);
+		return (NULL);
+	}
+
+	return (shm);
+}
+
+wd_shm_t *WDShmAttach(int fd)
+{
+	wd_shm_t *shm = (wd_shm_t *)malloc(sizeof(wd_shm_t));
+	if (!shm)
+	{
+		return (NULL);
+	}
+
+	shm->page = (page_t *)mmap(NULL, sizeof(page_t), PROT_READ | PROT_WRITE,
+							   MAP_SHARED, fd, 0);
+	if (MAP_FAILED == shm->page)
+	{
+		free(shm);
+		return (NULL);
+	}
+
+	shm->fd = fd;
+	shm->pid = getpid();
+
+	return (shm);
+}
+
+void WDShmDetach(wd_shm_t *shm)
+{
+	if (!shm)
+	{
+		return;
+	}
+
+	munmap(shm->page, sizeof(page_t));
+	close(shm->fd);
+	free(shm);
+}
+
+int WDShmGetFd(const wd_shm_t *shm)
+{
+	assert(shm);
+
+	return (shm->fd);
+}
+
+void WDShmBeat(wd_shm_t *shm, wd_side_t side)
+{
+	side_slot_t *slot = NULL;
+
+	assert(shm);
+	assert(side < WD_SIDES);
+
+	slot = &shm->page->sides[side];
+
+	/* The time goes out first, whoever sees the new number sees it too */
+	atomic_store_explicit(&slot->beat_ns, NowNs(), memory_order_relaxed);
+	atomic_fetch_add_explicit(&slot->seq, 1, memory_order_release);
+}
+
+uint64_t WDShmGetBeat(const wd_shm_t *shm, wd_side_t side, uint64_t *beat_ns)
+{
+	side_slot_t *slot = NULL;
+	uint64_t seq = 0;
+
+	assert(shm);
+	assert(side < WD_SIDES);
+
+	slot = &shm->page->sides[side];
+
+	seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+	if (beat_ns)
+	{
+		*beat_ns = atomic_load_explicit(&slot->beat_ns, memory_order_relaxed);
+	}
+
+	return (seq);
+}
+
+void WDShmGateWait(wd_shm_t *shm)
+{
+	assert(shm);
+
+	while (0 != sem_wait(&shm->page->gate) && EINTR == errno)
+	{
+	}
+}
+
+void WDShmGateOpen(wd_shm_t *shm)
+{
+	assert(shm);
+
+	sem_post(&shm->page->gate);
+}
+
+long WDShmRestartDelay(wd_shm_t *shm, wd_side_t side, 
+						const wd_restart_policy_t *policy)
+{
+	side_slot_t *slot = NULL;
+	uint64_t now = NowNs();
+	unsigned int seed = (unsigned int)(now ^ (now >> 32));
+	unsigned long delay = 0;
+	unsigned long shift = 0;
+
+	assert(shm);
+	assert(side < WD_SIDES);
+	assert(policy);
+
+	slot = &shm->page->sides[side];
+
+	if (0 == slot->restarts || 
+		now - slot->window_ns > (uint64_t)policy->window_ms * 1000000)
+	{
+		slot->window_ns = now;
+		slot->restarts = 0;
+	}
+
+	if (slot->restarts >= policy->budget)
+	{
+		return (WD_GIVE_UP);
+	}
+
+	/* The first restart of a window is right away, it may be a one off */
+	if (0 == slot->restarts++)
+	{
+		return (0);
+	}
+
+	shift = slot->restarts - 2;
+	delay = policy->backoff_max_ms;
+	if (shift < sizeof(delay) * 8 - 1 && 
+		policy->backoff_ms < (policy->backoff_max_ms >> shift))
+	{
+		delay = policy->backoff_ms << shift;
+	}
+
+	/* Between half and all of it, so clients that died together spread out */
+	return ((long)(delay / 2 + (unsigned long)rand_r(&seed) % (delay / 2 + 1)));
+}
+
+void WDShmOpenIncident(wd_shm_t *shm, wd_side_t side, wd_cause_t cause, 
+					   pid_t pid)
+{
+	incident_slot_t *incident = NULL;
+	uint64_t index = 0;
+	int phase = 0;
+
+	assert(shm);
+	assert(side < WD_SIDES);
+
+	index = atomic_fetch_add(&shm->page->n_incidents, 1) % WD_INCIDENTS;
+	incident = &shm->page->incidents[index];
+
+	for (phase = 0; phase < WD_PHASES; ++phase)
+	{
+		atomic_store_explicit(&incident->phase_ns[phase], 0, 
+							  memory_order_relaxed);
+	}
+
+	atomic_store_explicit(&incident->side, side, memory_order_relaxed);
+	atomic_store_explicit(&incident->cause, cause, memory_order_relaxed);
+	atomic_store_explicit(&incident->pid, pid, memory_order_relaxed);
+	atomic_store_explicit(&incident->phase_ns[WD_PHASE_LAST_SEEN], 
+						  atomic_load(&shm->page->sides[side].beat_ns), 
+						  memory_order_relaxed);
+	atomic_store_explicit(&incident->phase_ns[WD_PHASE_DECLARED], NowNs(), 
+						  memory_order_relaxed);
+
+	atomic_store(&shm->page->sides[side].incident, (int)index + 1);
+}
+
+void WDShmMarkIncident(wd_shm_t *shm, wd_side_t side, wd_phase_t phase)
+{
+	int index = 0;
+
+	assert(shm);
+	assert(side < WD_SIDES);
+	assert(phase < WD_PHASES);
+
+	/* The last phase closes the incident */
+	index = WD_PHASE_SYNCED == phase 
+			? atomic_exchange(&shm->page->sides[side].incident, 0)
+			: atomic_load(&shm->page->sides[side].incident);
+	if (0 == index)
+	{
+		return;
+	}
+
+	atomic_store_explicit(&shm->page->incidents[index - 1].phase_ns[phase], 
+						  NowNs(), memory_order_relaxed);
+}
+
+size_t WDShmGetIncidents(const wd_shm_t *shm, wd_incident_t *incidents, 
+						 size_t max)
+{
+	const incident_slot_t *incident = NULL;
+	uint64_t n_incidents = 0;
+	size_t i = 0;
+	int phase = 0;
+
+	assert(shm);
+	assert(incidents || 0 == max);
+
+	n_incidents = atomic_load(&shm->page->n_incidents);
+
+	for (i = 0; i < max && i < n_incidents && i < WD_INCIDENTS; ++i)
+	{
+		incident = &shm->page->incidents[(n_incidents - 1 - i) % WD_INCIDENTS];
+
+		incidents[i].side = (wd_side_t)atomic_load(&incident->side);
+		incidents[i].cause = (wd_cause_t)atomic_load(&incident->cause);
+		incidents[i].pid = atomic_load(&incident->pid);
+		for (phase = 0; phase < WD_PHASES; ++phase)
+		{
+			incidents[i].phase_ns[phase] = atomic_load_explicit(
+							&incident->phase_ns[phase], memory_order_relaxed);
+		}
+	}
+
+	return (i);
+}
+
+void WDShmTrace(wd_shm_t *shm, wd_side_t side, wd_event_t event, 
+				uint64_t arg)
+{
+	trace_ring_t *ring = NULL;
+	trace_slot_t *slot = NULL;
+	uint64_t index = 0;
+
+	assert(shm);
+	assert(side < WD_SIDES);
+
+	ring = &shm->page->traces[side];
+	index = atomic_fetch_add_explicit(&ring->head, 1, memory_order_relaxed);
+	slot = &ring->slots[index % WD_TRACE_EVENTS];
+
+	atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	atomic_store_explicit(&slot->ns, NowNs(), memory_order_relaxed);
+	atomic_store_explicit(&slot->arg, arg, memory_order_relaxed);
+	atomic_store_explicit(&slot->pid, shm->pid, memory_order_relaxed);
+	atomic_store_explicit(&slot->event, event, memory_order_relaxed);
+
+	atomic_store_explicit(&slot->seq, index + 1, memory_order_release);
+}
+
+size_t WDShmGetTrace(const wd_shm_t *shm, wd_side_t side, 
+					 wd_trace_event_t *events, size_t max)
+{
+	const trace_ring_t *ring = NULL;
+	const trace_slot_t *slot = NULL;
+	uint64_t head = 0;
+	uint64_t index = 0;
+	uint64_t seq = 0;
+	size_t n_events = 0;
+
+	assert(shm);
+	assert(side < WD_SIDES);
+	assert(events || 0 == max);
+
+	ring = &shm->page->traces[side];
+	head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	index = head > WD_TRACE_EVENTS ? head - WD_TRACE_EVENTS : 0;
+	if (head - index > max)
+	{
+		index = head - max;
+	}
+
+	for (; index < head; ++index)
+	{
+		slot = &ring->slots[index % WD_TRACE_EVENTS];
+
+		seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+		events[n_events].side = side;
+		events[n_events].ns = atomic_load_explicit(&slot->ns, 
+												   memory_order_relaxed);
+		events[n_events].arg = atomic_load_explicit(&slot->arg, 
+													memory_order_relaxed);
+		events[n_events].pid = atomic_load_explicit(&slot->pid, 
+													memory_order_relaxed);
+		events[n_events].event = (wd_event_t)atomic_load_explicit(
+									&slot->event, memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+
+		/* Torn by a writer, or one that died half way through */
+		if (index + 1 == seq && 
+			seq == atomic_load_explicit(&slot->seq, memory_order_relaxed))
+		{
+			++n_events;
+		}
+	}
+
+	return (n_events);
+}
+
+void WDShmPost(wd_shm_t *shm, wd_side_t side)
+{
+	assert(shm);
+	assert(side < WD_SIDES);
+
+	sem_post(&shm->page->wake[side]);
+}
+
+int WDShmWait(wd_shm_t *shm, wd_side_t side, unsigned long timeout_ms)
+{
+	struct timespec deadline;
+
+	assert(shm);
+	assert(side < WD_SIDES);
+
+	/* On the monotonic clock, a change of the time of day can't cut it short */
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec += timeout_ms / 1000;
+	deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+	if (deadline.tv_nsec >= 1000000000)
+	{
+		++deadline.tv_sec;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	while (0 != sem_clockwait(&shm->page->wake[side], CLOCK_MONOTONIC, 
+							  &deadline))
+	{
+		if (EINTR != errno)
+		{
+			return (1);
+		}
+	}
+
+	return (0);
+}
+
+void WDShmStop(wd_shm_t *shm, wd_side_t side)
+{
+	assert(shm);
+	assert(side < WD_SIDES);
+
+	atomic_store(&shm->page->sides[side].stop, 1);
+}
+
+int WDShmIsStopped(const wd_shm_t *shm, wd_side_t side)
+{
+	assert(shm);
+	assert(side < WD_SIDES);
+
+	return (atomic_load(&shm->page->sides[side].stop));
+}
+
+int WDShmClaimThread(wd_shm_t *shm, unsigned long timeout_ms)
+{
+	thread_slot_t *slot = NULL;
+	int expected = 0;
+	int id = 0;
+
+	assert(shm);
+	assert(0 != timeout_ms);
+
+	for (id = 0; id < WD_THREADS; ++id)
+	{
+		slot = &shm->page->threads[id];
+		expected = 0;
+		if (atomic_compare_exchange_strong(&slot->used, &expected, 1))
+		{
+			/* 
+			 * Kicked before it's armed, so a checker that sees the timeout
+			 * sees a new kick too, not the last one of the previous owner
+			 */
+			WDShmKick(shm, id);
+			atomic_store_explicit(&slot->timeout_ns, 
+								  (uint64_t)timeout_ms * 1000000, 
+								  memory_order_release);
+			return (id);
+		}
+	}
+
+	return (-1);
+}
+
+void WDShmReleaseThread(wd_shm_t *shm, int id)
+{
+	assert(shm);
+	assert(0 <= id && id < WD_THREADS);
+
+	ReleaseThread(&shm->page->threads[id]);
+}
+
+void WDShmKick(wd_shm_t *shm, int id)
+{
+	thread_slot_t *slot = NULL;
+	uint64_t kicks = 0;
+
+	assert(shm);
+	assert(0 <= id && id < WD_THREADS);
+
+	slot = &shm->page->threads[id];
+
+	/* The owner is the only writer, no read-modify-write needed */
+	kicks = atomic_load_explicit(&slot->kicks, memory_order_relaxed);
+	atomic_store_explicit(&slot->kicks, kicks + 1, memory_order_relaxed);
+}
+
+int WDShmFindStalled(wd_shm_t *shm)
+{
+	thread_slot_t *slot = NULL;
+	uint64_t timeout_ns = 0;
+	uint64_t kicks = 0;
+	uint64_t now = NowNs();
+	int id = 0;
+
+	assert(shm);
+
+	for (id = 0; id < WD_THREADS; ++id)
+	{
+		slot = &shm->page->threads[id];
+		timeout_ns = atomic_load_explicit(&slot->timeout_ns, 
+										  memory_order_acquire);
+		if (0 == timeout_ns)
+		{
+			slot->seen_ns = 0;
+			continue;
+		}
+
+		kicks = atomic_load_explicit(&slot->kicks, memory_order_relaxed);
+		if (0 == slot->seen_ns || kicks != slot->seen_kicks)
+		{
+			slot->seen_kicks = kicks;
+			slot->seen_ns = now;
+		}
+		else if (now - slot->seen_ns > timeout_ns)
+		{
+			return (id);
+		}
+	}
+
+	return (-1);
+}
+
+void WDShmResetThreads(wd_shm_t *shm)
+{
+	int id = 0;
+
+	assert(shm);
+
+	for (id = 0; id < WD_THREADS; ++id)
+	{
+		ReleaseThread(&shm->page->threads[id]);
+	}
+}
+
+/*							  Static Functions								  */
+/******************************************************************************/
+
+static uint64_t NowNs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec);
+}
+
+/* Disarmed first, a checker mustn't see a free slot as a stalled one */
+static void ReleaseThread(thread_slot_t *slot)
+{
+	atomic_store_explicit(&slot->timeout_ns, 0, memory_order_relaxed);
+	atomic_store(&slot->used, 0);
+}
@@ -0,0 +1,167 @@
+/*
+	Name: Guy Feigin
+	Exercise: Watchdog spawn
+	File type: Source code
+	Reviewer:
+	Last updated: Sun 18 Oct 2026 10:02:31
+*/
+
+#define _GNU_SOURCE /* posix_spawn_file_actions_addchdir_np() */
+
+#include <stdlib.h> /* malloc(), realpath() */
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* strchr() */
+#include <assert.h> /* assert() */
+#include <limits.h> /* PATH_MAX */
+#include <signal.h> /* sigset_t */
+#include <spawn.h> /* posix_spawn() */
+#include <unistd.h> /* access() */
+
+#include "wd_spawn.h" /* WDSpawn() */
+
+extern char **environ;
+
+static int IsReplaced(const char *entry, char *const env[]);
+
+/*							  Global Functions								  */
+/******************************************************************************/
+
+int WDSpawnResolve(const char *name, char *resolved)
+{
+	char candidate[PATH_MAX] = {0};
+	const char *dir = getenv("PATH");
+	size_t dir_len = 0;
+
+	assert(name);
+	assert(resolved);
+
+	if (strchr(name, '/'))
+	{
+		return (realpath(name, resolved) ? 0 : 1);
+	}
+
+	for (; dir && '\0' != *dir; dir += dir_len + (':' == dir[dir_len]))
+	{
+		dir_len = strcspn(dir, ":");
+		snprintf(candidate, sizeof(candidate), "%.*s/%s", (int)dir_len, dir,
+				 name);
+
+		if (0 == access(candidate, X_OK) && realpath(candidate, resolved))
+		{
+			return (0);
+		}
+	}
+
+	return (1);
+}
+
+int WDSpawn(pid_t *pid, const char *path, char *const argv[], const char *dir,
+			const int *fds, size_t n_fds, char *const env[])
+{
+	posix_spawn_file_actions_t actions;
+	posix_spawnattr_t attr;
+	sigset_t default_set;
+	char **envp = NULL;
+	size_t n_env = 0;
+	size_t n_extra = 0;
+	size_t i = 0;
+	int status = 0;
+
+	assert(pid);
+	assert(path);
+	assert(argv);
+	assert(fds || 0 == n_fds);
+
+	while (environ[n_env])
+	{
+		++n_env;
+	}
+
+	while (env && env[n_extra])
+	{
+		++n_extra;
+	}
+
+	envp = (char **)malloc((n_env + n_extra + 1) * sizeof(char *));
+	if (!envp)
+	{
+		return (1);
+	}
+
+	if (0 != posix_spawn_file_actions_init(&actions))
+	{
+		free(envp);
+		return (1);
+	}
+
+	if (0 != posix_spawnattr_init(&attr))
+	{
+		posix_spawn_file_actions_destroy(&actions);
+		free(envp);
+		return (1);
+	}
+
+	for (n_env = 0, i = 0; environ[i]; ++i)
+	{
+		if (!IsReplaced(environ[i], env))
+		{
+			envp[n_env++] = environ[i];
+		}
+	}
+
+	for (i = 0; i < n_extra; ++i)
+	{
+		envp[n_env++] = env[i];
+	}
+
+	envp[n_env] = NULL;
+
+	/* Onto itself, which only clears its close-on-exec in the child */
+	for (i = 0; i < n_fds && 0 == status; ++i)
+	{
+		status = posix_spawn_file_actions_adddup2(&actions, fds[i], fds[i]);
+	}
+
+	if (0 == status && dir)
+	{
+		status = posix_spawn_file_actions_addchdir_np(&actions, dir);
+	}
+
+	/* An ignored SIGCHLD, as a supervisor has, would be inherited */
+	sigemptyset(&default_set);
+	sigaddset(&default_set, SIGCHLD);
+	if (0 == status)
+	{
+		status = posix_spawnattr_setsigdefault(&attr, &default_set) ||
+				 posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+	}
+
+	if (0 == status)
+	{
+		status = posix_spawn(pid, path, &actions, &attr, argv, envp);
+	}
+
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&actions);
+	free(envp);
+
+	return (0 == status ? 0 : 1);
+}
+
+/*							  Static Functions								  */
+/******************************************************************************/
+
+static int IsReplaced(const char *entry, char *const env[])
+{
+	size_t name_len = strcspn(entry, "=");
+
+	for (; env && *env; ++env)
+	{
+		if (0 == strncmp(entry, *env, name_len + 1))
+		{
+			return (1);
+		}
+	}
+
+	return (0);
+}
@@ -0,0 +1,682 @@
+/*
+	Name: Guy Feigin
+	Exercise: Watchdog supervisor
+	File type: Source code
+	Reviewer:
+	Last updated: Sun 18 Oct 2026 00:12:40
+*/
+
+#define _GNU_SOURCE /* accept4(), MSG_CMSG_CLOEXEC */
+
+#include <stdlib.h> /* malloc() */
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* strlen() */
+#include <assert.h> /* assert() */
+#include <errno.h> /* EINTR */
+#include <signal.h> /* kill() */
+#include <stdatomic.h> /* atomic_int */
+#include <unistd.h> /* getcwd() */
+#include <sys/socket.h> /* sendmsg() */
+#include <sys/un.h> /* struct sockaddr_un */
+#include <sys/stat.h> /* chmod() */
+#include <limits.h> /* PATH_MAX */
+
+#include "scheduler.h" /* scheduler_t */
+#include "uidmap.h" /* uidmap_t */
+#include "wd_shm.h" /* wd_shm_t */
+#include "wd_phi.h" /* wd_phi_t */
+#include "wd_spawn.h" /* WDSpawn() */
+#include "wd_supervisor.h" /* wd_supervisor_t */
+
+#define CMD_SIZE (4096)
+#define MIN_CMD_STRINGS (3) /* Working directory, executable and argv[0] */
+#define POLL_MS (100)
+#define NO_FD (-1)
+#define ACK (1)
+
+typedef struct client client_t;
+
+/* The first and only message of a client, sent along with its page */
+typedef struct registration
+{
+	unsigned long heartbeat_ms;
+	unsigned long miss_threshold;
+	unsigned long false_positive_ppm;
+	wd_restart_policy_t restart;
+	size_t cmd_size;
+	char cmd[CMD_SIZE]; /* Working directory, executable, then arguments */
+} registration_t;
+
+struct client
+{
+	wd_supervisor_t *sup;
+	ilrd_uid_t id;
+	ilrd_uid_t check_uid;
+	int conn_fd;
+	wd_shm_t *shm;
+	pid_t pid;
+	uint64_t seq;
+	unsigned long misses;
+	wd_phi_t *phi;
+	wd_cause_t cause; /* Why it was killed, if it was */
+	unsigned long heartbeat_ms;
+	unsigned long miss_threshold;
+	unsigned long false_positive_ppm;
+	wd_restart_policy_t restart;
+	size_t cmd_size;
+	char *cmd;
+};
+
+struct wd_supervisor
+{
+	scheduler_t *sched;
+	uidmap_t *clients;
+	int listen_fd;
+	atomic_int stop;
+	char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+};
+
+static int Accept(int fd, void *param);
+static int ClientReadable(int fd, void *param);
+static int Register(client_t *client);
+static void ClientGone(client_t *client);
+static void Spawn(const client_t *client);
+static int SpawnLater(void *param);
+static void DropClient(client_t *client);
+static int FreeClientAction(void *value, void *param);
+static int CheckClient(void *param);
+static int CheckStop(void *param);
+static int Connect(const char *path);
+static int PackCmd(registration_t *reg, char *const argv[]);
+static size_t CountStrings(const char *cmd, size_t size);
+
+/*							  Global Functions								  */
+/******************************************************************************/
+
+wd_supervisor_t *WDSupervisorCreate(const char *path)
+{
+	struct sockaddr_un addr = {0};
+	wd_supervisor_t *sup = NULL;
+
+	assert(path);
+
+	if (strlen(path) >= sizeof(addr.sun_path))
+	{
+		return (NULL);
+	}
+
+	sup = (wd_supervisor_t *)malloc(sizeof(wd_supervisor_t));
+	if (!sup)
+	{
+		return (NULL);
+	}
+
+	/* Thousands of periodic checks, the wheel keeps each one O(1) */
+	sup->sched = SchedCreateWheel();
+	sup->clients = UIDMapCreate(0);
+	sup->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC |
+						   SOCK_NONBLOCK, 0);
+	atomic_init(&sup->stop, 0);
+	strcpy(sup->path, path);
+	strcpy(addr.sun_path, path);
+	addr.sun_family = AF_UNIX;
+	unlink(path);
+
+	if (!sup->sched || !sup->clients || NO_FD == sup->listen_fd ||
+		0 != bind(sup->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+		0 != chmod(path, S_IRUSR | S_IWUSR) ||
+		0 != listen(sup->listen_fd, SOMAXCONN) ||
+		SUCCESS != SchedWatchFd(sup->sched, sup->listen_fd, Accept, sup) ||
+		UIDIsEqual(bad_uid, SchedAddTaskMs(sup->sched, POLL_MS, CheckStop,
+										   sup, NULL, NULL)))
+	{
+		WDSupervisorDestroy(sup);
+		return (NULL);
+	}
+
+	return (sup);
+}
+
+void WDSupervisorDestroy(wd_supervisor_t *sup)
+{
+	if (!sup)
+	{
+		return;
+	}
+
+	if (sup->clients)
+	{
+		UIDMapForEach(sup->clients, FreeClientAction, NULL);
+		UIDMapDestroy(sup->clients);
+	}
+
+	if (sup->sched)
+	{
+		SchedDestroy(sup->sched);
+	}
+
+	if (NO_FD != sup->listen_fd)
+	{
+		close(sup->listen_fd);
+		unlink(sup->path);
+	}
+
+	free(sup);
+}
+
+int WDSupervisorRun(wd_supervisor_t *sup)
+{
+	int status = SUCCESS;
+
+	assert(sup);
+
+	signal(SIGCHLD, SIG_IGN);
+
+	status = SchedRun(sup->sched);
+
+	return (STOP == status || SUCCESS == status ? 0 : 1);
+}
+
+void WDSupervisorStop(wd_supervisor_t *sup)
+{
+	assert(sup);
+
+	atomic_store(&sup->stop, 1);
+}
+
+size_t WDSupervisorCount(const wd_supervisor_t *sup)
+{
+	assert(sup);
+
+	return (UIDMapCount(sup->clients));
+}
+
+int WDSupervisorRegister(const char *path, int shm_fd, char *const argv[],
+						 unsigned long heartbeat_ms,
+						 unsigned long miss_threshold,
+						 unsigned long false_positive_ppm,
+						 const wd_restart_policy_t *restart)
+{
+	char control[CMSG_SPACE(sizeof(int))] = {0};
+	registration_t *reg = NULL;
+	struct msghdr msg = {0};
+	struct cmsghdr *cmsg = NULL;
+	struct iovec iov;
+	char ack = 0;
+	int fd = NO_FD;
+
+	assert(path);
+	assert(argv);
+	assert(restart);
+
+	reg = (registration_t *)calloc(1, sizeof(registration_t));
+	if (!reg)
+	{
+		return (NO_FD);
+	}
+
+	reg->heartbeat_ms = heartbeat_ms;
+	reg->miss_threshold = miss_threshold;
+	reg->false_positive_ppm = false_positive_ppm;
+	reg->restart = *restart;
+
+	fd = Connect(path);
+	if (NO_FD == fd || 0 != PackCmd(reg, argv))
+	{
+		free(reg);
+		if (NO_FD != fd)
+		{
+			close(fd);
+		}
+
+		return (NO_FD);
+	}
+
+	iov.iov_base = reg;
+	iov.iov_len = sizeof(registration_t);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &shm_fd, sizeof(int));
+
+	/* Protected only once the supervisor acknowledged */
+	if (sizeof(registration_t) != sendmsg(fd, &msg, MSG_NOSIGNAL) ||
+		1 != recv(fd, &ack, 1, 0) || ACK != ack)
+	{
+		close(fd);
+		fd = NO_FD;
+	}
+
+	free(reg);
+
+	return (fd);
+}
+
+/*							  Static Functions								  */
+/******************************************************************************/
+
+static int Accept(int fd, void *param)
+{
+	wd_supervisor_t *sup = (wd_supervisor_t *)param;
+	client_t *client = NULL;
+	int conn_fd = NO_FD;
+
+	for (conn_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		 NO_FD != conn_fd;
+		 conn_fd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC))
+	{
+		client = (client_t *)calloc(1, sizeof(client_t));
+		if (!client)
+		{
+			close(conn_fd);
+			continue;
+		}
+
+		client->sup = sup;
+		client->id = UIDGenerate();
+		client->check_uid = bad_uid;
+		client->conn_fd = conn_fd;
+
+		if (0 != UIDMapInsert(sup->clients, client->id, client))
+		{
+			FreeClientAction(client, NULL);
+			continue;
+		}
+
+		if (SUCCESS != SchedWatchFd(sup->sched, conn_fd, ClientReadable,
+									client))
+		{
+			UIDMapRemove(sup->clients, client->id);
+			FreeClientAction(client, NULL);
+		}
+	}
+
+	return (REPEAT);
+}
+
+/* The first message registers the client, the end of the stream is its end */
+static int ClientReadable(int fd, void *param)
+{
+	client_t *client = (client_t *)param;
+	char byte = 0;
+	ssize_t n_read = 0;
+
+	if (UIDIsEqual(bad_uid, client->check_uid))
+	{
+		if (0 != Register(client))
+		{
+			DropClient(client);
+			return (SUCCESS);
+		}
+
+		return (REPEAT);
+	}
+
+	n_read = recv(fd, &byte, 1, MSG_DONTWAIT);
+	if (0 < n_read || (0 > n_read && (EAGAIN == errno || EINTR == errno)))
+	{
+		return (REPEAT);
+	}
+
+	ClientGone(client);
+
+	return (SUCCESS);
+}
+
+static int Register(client_t *client)
+{
+	char control[CMSG_SPACE(sizeof(int))] = {0};
+	registration_t *reg = NULL;
+	struct msghdr msg = {0};
+	struct cmsghdr *cmsg = NULL;
+	struct iovec iov;
+	struct ucred cred = {0};
+	socklen_t cred_len = sizeof(cred);
+	char ack = ACK;
+	int shm_fd = NO_FD;
+	int status = 1;
+
+	/* The pid that gets killed is the kernel's word, not the client's */
+	if (0 != getsockopt(client->conn_fd, SOL_SOCKET, SO_PEERCRED, &cred, 
+						&cred_len) || 0 >= cred.pid)
+	{
+		return (1);
+	}
+
+	reg = (registration_t *)malloc(sizeof(registration_t));
+	if (!reg)
+	{
+		return (1);
+	}
+
+	iov.iov_base = reg;
+	iov.iov_len = sizeof(registration_t);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	/* The page must not leak into the other clients' revived processes */
+	if (sizeof(registration_t) == recvmsg(client->conn_fd, &msg,
+										  MSG_CMSG_CLOEXEC))
+	{
+		cmsg = CMSG_FIRSTHDR(&msg);
+		if (cmsg && SCM_RIGHTS == cmsg->cmsg_type)
+		{
+			memcpy(&shm_fd, CMSG_DATA(cmsg), sizeof(int));
+		}
+	}
+
+	/* Spawn walks the strings of the command, all of them must be there */
+	if (NO_FD != shm_fd && reg->cmd_size <= CMD_SIZE &&
+		MIN_CMD_STRINGS <= CountStrings(reg->cmd, reg->cmd_size) &&
+		0 != reg->heartbeat_ms && 0 != reg->false_positive_ppm &&
+		0 != reg->restart.budget && 0 != reg->restart.window_ms &&
+		0 != reg->restart.backoff_ms && 0 != reg->restart.backoff_max_ms)
+	{
+		client->shm = WDShmAttach(shm_fd);
+		client->cmd = (char *)malloc(reg->cmd_size);
+		client->phi = WDPhiCreate(reg->heartbeat_ms, reg->false_positive_ppm);
+	}
+
+	if (client->shm && client->cmd && client->phi)
+	{
+		memcpy(client->cmd, reg->cmd, reg->cmd_size);
+		client->cmd_size = reg->cmd_size;
+		client->pid = cred.pid;
+		client->heartbeat_ms = reg->heartbeat_ms;
+		client->miss_threshold = reg->miss_threshold;
+		client->false_positive_ppm = reg->false_positive_ppm;
+		client->restart = reg->restart;
+		client->cause = WD_CAUSE_EXITED;
+		client->seq = WDShmGetBeat(client->shm, WD_SIDE_USER, NULL);
+		client->check_uid = SchedAddTaskMs(client->sup->sched,
+										   client->heartbeat_ms, CheckClient,
+										   client, NULL, NULL);
+
+		status = UIDIsEqual(bad_uid, client->check_uid) ||
+				 1 != send(client->conn_fd, &ack, 1, MSG_NOSIGNAL);
+
+		/* A revived client coming back ends its revive */
+		WDShmMarkIncident(client->shm, WD_SIDE_USER, WD_PHASE_SYNCED);
+	}
+	else if (!client->shm && NO_FD != shm_fd)
+	{
+		close(shm_fd);
+	}
+
+	free(reg);
+
+	return (status);
+}
+
+/* 
+ * The process closed its end, by WDStop or by dying. One that died too
+ * often lately is kept until it's revived by SpawnLater, or given up on
+ */
+static void ClientGone(client_t *client)
+{
+	wd_supervisor_t *sup = client->sup;
+	long delay_ms = 0;
+
+	if (WDShmIsStopped(client->shm, WD_SIDE_WD))
+	{
+		DropClient(client);
+		return;
+	}
+
+	WDShmOpenIncident(client->shm, WD_SIDE_USER, client->cause, client->pid);
+	delay_ms = WDShmRestartDelay(client->shm, WD_SIDE_USER, &client->restart);
+	if (0 == delay_ms)
+	{
+		WDShmResetThreads(client->shm);
+		WDShmMarkIncident(client->shm, WD_SIDE_USER, WD_PHASE_SPAWNED);
+		Spawn(client);
+	}
+	else if (WD_GIVE_UP != delay_ms)
+	{
+		SchedUnwatchFd(sup->sched, client->conn_fd);
+		close(client->conn_fd);
+		client->conn_fd = NO_FD;
+
+		/* The check task is done with, the client's task is the spawn now */
+		SchedRemoveTask(sup->sched, client->check_uid);
+		client->check_uid = SchedAddTaskMs(sup->sched, (size_t)delay_ms,
+										   SpawnLater, client, NULL, NULL);
+		if (!UIDIsEqual(bad_uid, client->check_uid))
+		{
+			return;
+		}
+	}
+
+	DropClient(client);
+}
+
+static int SpawnLater(void *param)
+{
+	client_t *client = (client_t *)param;
+
+	WDShmResetThreads(client->shm);
+	WDShmMarkIncident(client->shm, WD_SIDE_USER, WD_PHASE_SPAWNED);
+	Spawn(client);
+
+	/* Returning SUCCESS removes this task */
+	client->check_uid = bad_uid;
+	DropClient(client);
+
+	return (SUCCESS);
+}
+
+/* 
+ * The revived process registers on its own, as a new client. It's started
+ * from the executable its first process resolved, in its working directory
+ */
+static void Spawn(const client_t *client)
+{
+	char **argv = NULL;
+	char path_env[sizeof(client->sup->path) + 16] = {0};
+	char fd_env[32] = {0};
+	char config_env[224] = {0};
+	char *env[4] = {NULL};
+	const char *exec_path = client->cmd + strlen(client->cmd) + 1;
+	const char *arg = NULL;
+	size_t n_args = 0;
+	int shm_fd = WDShmGetFd(client->shm);
+	pid_t pid = 0;
+
+	for (arg = exec_path + strlen(exec_path) + 1;
+		 arg < client->cmd + client->cmd_size; arg += strlen(arg) + 1)
+	{
+		++n_args;
+	}
+
+	argv = (char **)calloc(n_args + 1, sizeof(char *));
+	if (!argv)
+	{
+		return;
+	}
+
+	for (n_args = 0, arg = exec_path + strlen(exec_path) + 1;
+		 arg < client->cmd + client->cmd_size; arg += strlen(arg) + 1)
+	{
+		argv[n_args++] = (char *)arg;
+	}
+
+	snprintf(path_env, sizeof(path_env), "WD_SUPERVISOR=%s", 
+			 client->sup->path);
+	snprintf(fd_env, sizeof(fd_env), "WD_SHM_FD=%d", shm_fd);
+	snprintf(config_env, sizeof(config_env), 
+			 "WD_CONFIG=%lu,%lu,0,0,%lu,%lu,%lu,%lu,%lu",
+			 client->heartbeat_ms, client->miss_threshold,
+			 client->restart.budget, client->restart.window_ms,
+			 client->restart.backoff_ms, client->restart.backoff_max_ms,
+			 client->false_positive_ppm);
+	env[0] = path_env;
+	env[1] = fd_env;
+	env[2] = config_env;
+
+	WDSpawn(&pid, exec_path, argv, client->cmd, &shm_fd, 1, env);
+
+	free(argv);
+}
+
+static void DropClient(client_t *client)
+{
+	wd_supervisor_t *sup = client->sup;
+
+	if (NO_FD != client->conn_fd)
+	{
+		SchedUnwatchFd(sup->sched, client->conn_fd);
+	}
+
+	if (!UIDIsEqual(bad_uid, client->check_uid))
+	{
+		SchedRemoveTask(sup->sched, client->check_uid);
+	}
+
+	UIDMapRemove(sup->clients, client->id);
+	FreeClientAction(client, NULL);
+}
+
+static int FreeClientAction(void *value, void *param)
+{
+	client_t *client = (client_t *)value;
+
+	(void)param;
+
+	if (NO_FD != client->conn_fd)
+	{
+		close(client->conn_fd);
+	}
+
+	WDShmDetach(client->shm);
+	WDPhiDestroy(client->phi);
+	free(client->cmd);
+	free(client);
+
+	return (0);
+}
+
+/* 
+ * A client that hangs, or has a watched thread that stalls, is killed. It's
+ * revived once its connection closes. A hang is caught by the detector as
+ * soon as the client's own jitter allows, or after too many missed beats
+ */
+static int CheckClient(void *param)
+{
+	client_t *client = (client_t *)param;
+	uint64_t beat_ns = 0;
+	uint64_t seq = WDShmGetBeat(client->shm, WD_SIDE_USER, &beat_ns);
+
+	if (seq != client->seq)
+	{
+		client->seq = seq;
+		client->misses = 0;
+		WDPhiBeat(client->phi, seq, beat_ns);
+	}
+	else if (++client->misses > client->miss_threshold || 
+			 WDPhiIsSuspect(client->phi))
+	{
+		client->cause = WD_CAUSE_HUNG;
+		kill(client->pid, SIGKILL);
+		client->misses = 0;
+	}
+	else if (-1 != WDShmFindStalled(client->shm))
+	{
+		client->cause = WD_CAUSE_STALLED;
+		kill(client->pid, SIGKILL);
+		client->misses = 0;
+	}
+
+	return (REPEAT);
+}
+
+static int CheckStop(void *param)
+{
+	wd_supervisor_t *sup = (wd_supervisor_t *)param;
+
+	return (atomic_load(&sup->stop) ? STOP : REPEAT);
+}
+
+static int Connect(const char *path)
+{
+	struct sockaddr_un addr = {0};
+	int fd = NO_FD;
+
+	if (strlen(path) >= sizeof(addr.sun_path))
+	{
+		return (NO_FD);
+	}
+
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (NO_FD != fd && 0 != connect(fd, (struct sockaddr *)&addr,
+									sizeof(addr)))
+	{
+		close(fd);
+		fd = NO_FD;
+	}
+
+	return (fd);
+}
+
+/* The working directory and then every argument, each NUL terminated */
+static int PackCmd(registration_t *reg, char *const argv[])
+{
+	char exec_path[PATH_MAX] = {0};
+	size_t len = 0;
+
+	/* Resolved now, a revive mustn't depend on PATH as it is then */
+	if (!getcwd(reg->cmd, CMD_SIZE) || 0 != WDSpawnResolve(argv[0], exec_path))
+	{
+		return (1);
+	}
+
+	reg->cmd_size = strlen(reg->cmd) + 1;
+	len = strlen(exec_path) + 1;
+	if (reg->cmd_size + len > CMD_SIZE)
+	{
+		return (1);
+	}
+
+	memcpy(reg->cmd + reg->cmd_size, exec_path, len);
+	reg->cmd_size += len;
+
+	for (; *argv; ++argv)
+	{
+		len = strlen(*argv) + 1;
+		if (reg->cmd_size + len > CMD_SIZE)
+		{
+			return (1);
+		}
+
+		memcpy(reg->cmd + reg->cmd_size, *argv, len);
+		reg->cmd_size += len;
+	}
+
+	return (0);
+}
+
+/* Counts the strings of a command, none if the last one isn't terminated */
+static size_t CountStrings(const char *cmd, size_t size)
+{
+	size_t count = 0;
+	size_t i = 0;
+
+	assert(cmd);
+
+	for (i = 0; i < size; ++i)
+	{
+		count += '\0' == cmd[i];
+	}
+
+	return (0 != size && '\0' == cmd[size - 1] ? count : 0);
+}
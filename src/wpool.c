@@ -0,0 +1,375 @@
+/*
+	Name: Guy Feigin
+	Exercise: Worker pool
+	File type: Source code
+	Reviewer:
+	Last updated: Sat 17 Oct 2026 17:22:09
+*/
+
+#include <stdlib.h> /* malloc() */
+#include <assert.h> /* assert() */
+#include <pthread.h> /* pthread_create() */
+#include <stdatomic.h> /* atomic_size_t */
+
+#include "wpool.h" /* wpool_t */
+
+#define WP_SUCCESS (0)
+#define WP_FAIL (1)
+#define DEQUE_INIT_CAPACITY (64)
+
+/* A ring buffer of jobs, the capacity is always a power of 2 */
+typedef struct deque
+{
+	pthread_mutex_t lock;
+	void **jobs;
+	size_t head;
+	size_t count;
+	size_t capacity;
+} deque_t;
+
+typedef struct worker
+{
+	wpool_t *pool;
+	size_t id;
+	pthread_t thread;
+	deque_t deque;
+} worker_t;
+
+struct wpool
+{
+	wp_job_func_t job_func;
+	void *param;
+	size_t n_workers;
+	worker_t *workers;
+	atomic_size_t next;
+	atomic_size_t queued;
+	atomic_size_t sleepers;
+	int shutdown;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+
+static int DequeInit(deque_t *deque);
+static void DequeDestroy(deque_t *deque);
+static int DequePushBack(deque_t *deque, void *job);
+static void *DequePopFront(deque_t *deque);
+static void *DequePopBack(deque_t *deque);
+static void *Steal(wpool_t *pool, size_t thief);
+static int Sleep(wpool_t *pool);
+static void *WorkerMain(void *arg);
+static void StopWorkers(wpool_t *pool, size_t n_started);
+static void FreePool(wpool_t *pool, size_t n_deques);
+
+/*							  Global Functions								  */
+/******************************************************************************/
+
+wpool_t *WPoolCreate(size_t n_workers, wp_job_func_t job_func, void *param)
+{
+	wpool_t *pool = NULL;
+	size_t i = 0;
+
+	assert(0 < n_workers);
+	assert(job_func);
+
+	pool = (wpool_t *)malloc(sizeof(wpool_t));
+	if (!pool)
+	{
+		return (NULL);
+	}
+
+	pool->workers = (worker_t *)malloc(n_workers * sizeof(worker_t));
+	if (!pool->workers)
+	{
+		free(pool);
+		return (NULL);
+	}
+
+	pool->job_func = job_func;
+	pool->param = param;
+	pool->n_workers = n_workers;
+	pool->shutdown = 0;
+	atomic_init(&pool->next, 0);
+	atomic_init(&pool->queued, 0);
+	atomic_init(&pool->sleepers, 0);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+
+	/* All the deques exist before any worker may try to steal from them */
+	for (i = 0; i < n_workers; ++i)
+	{
+		if (WP_SUCCESS != DequeInit(&pool->workers[i].deque))
+		{
+			FreePool(pool, i);
+			return (NULL);
+		}
+
+		pool->workers[i].pool = pool;
+		pool->workers[i].id = i;
+	}
+
+	for (i = 0; i < n_workers; ++i)
+	{
+		if (0 != pthread_create(&pool->workers[i].thread, NULL, WorkerMain,
+								&pool->workers[i]))
+		{
+			StopWorkers(pool, i);
+			return (NULL);
+		}
+	}
+
+	return (pool);
+}
+
+void WPoolDestroy(wpool_t *pool)
+{
+	assert(pool);
+
+	StopWorkers(pool, pool->n_workers);
+}
+
+int WPoolSubmit(wpool_t *pool, void *job)
+{
+	worker_t *worker = NULL;
+	int status = WP_SUCCESS;
+
+	assert(pool);
+	assert(job);
+
+	worker = &pool->workers[atomic_fetch_add(&pool->next, 1) %
+							pool->n_workers];
+
+	pthread_mutex_lock(&worker->deque.lock);
+	status = DequePushBack(&worker->deque, job);
+	pthread_mutex_unlock(&worker->deque.lock);
+
+	if (WP_SUCCESS != status)
+	{
+		return (status);
+	}
+
+	/*
+		Pairs with Sleep: either the sleeper sees the job in queued, or this
+		sees the sleeper and wakes it up
+	*/
+	atomic_fetch_add(&pool->queued, 1);
+	if (0 != atomic_load(&pool->sleepers))
+	{
+		pthread_mutex_lock(&pool->lock);
+		pthread_cond_signal(&pool->cond);
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	return (WP_SUCCESS);
+}
+
+size_t WPoolSize(const wpool_t *pool)
+{
+	assert(pool);
+
+	return (pool->n_workers);
+}
+
+/*							  Static Functions								  */
+/******************************************************************************/
+
+static int DequeInit(deque_t *deque)
+{
+	assert(deque);
+
+	deque->jobs = (void **)malloc(DEQUE_INIT_CAPACITY * sizeof(void *));
+	if (!deque->jobs)
+	{
+		return (WP_FAIL);
+	}
+
+	deque->head = 0;
+	deque->count = 0;
+	deque->capacity = DEQUE_INIT_CAPACITY;
+	pthread_mutex_init(&deque->lock, NULL);
+
+	return (WP_SUCCESS);
+}
+
+static void DequeDestroy(deque_t *deque)
+{
+	assert(deque);
+
+	pthread_mutex_destroy(&deque->lock);
+	free(deque->jobs);
+}
+
+static int DequePushBack(deque_t *deque, void *job)
+{
+	void **new_jobs = NULL;
+	size_t i = 0;
+
+	assert(deque);
+
+	if (deque->count == deque->capacity)
+	{
+		new_jobs = (void **)malloc(deque->capacity * 2 * sizeof(void *));
+		if (!new_jobs)
+		{
+			return (WP_FAIL);
+		}
+
+		/* Unwrap the ring into the start of the new buffer */
+		for (i = 0; i < deque->count; ++i)
+		{
+			new_jobs[i] = deque->jobs[(deque->head + i) &
+									  (deque->capacity - 1)];
+		}
+
+		free(deque->jobs);
+		deque->jobs = new_jobs;
+		deque->head = 0;
+		deque->capacity *= 2;
+	}
+
+	deque->jobs[(deque->head + deque->count) & (deque->capacity - 1)] = job;
+	++deque->count;
+
+	return (WP_SUCCESS);
+}
+
+static void *DequePopFront(deque_t *deque)
+{
+	void *job = NULL;
+
+	assert(deque);
+
+	if (0 == deque->count)
+	{
+		return (NULL);
+	}
+
+	job = deque->jobs[deque->head];
+	deque->head = (deque->head + 1) & (deque->capacity - 1);
+	--deque->count;
+
+	return (job);
+}
+
+static void *DequePopBack(deque_t *deque)
+{
+	assert(deque);
+
+	if (0 == deque->count)
+	{
+		return (NULL);
+	}
+
+	--deque->count;
+
+	return (deque->jobs[(deque->head + deque->count) &
+						(deque->capacity - 1)]);
+}
+
+/* Takes the newest job of the first other worker that has one */
+static void *Steal(wpool_t *pool, size_t thief)
+{
+	deque_t *victim = NULL;
+	void *job = NULL;
+	size_t i = 0;
+
+	assert(pool);
+
+	for (i = 1; i < pool->n_workers && !job; ++i)
+	{
+		victim = &pool->workers[(thief + i) % pool->n_workers].deque;
+
+		pthread_mutex_lock(&victim->lock);
+		job = DequePopBack(victim);
+		pthread_mutex_unlock(&victim->lock);
+	}
+
+	return (job);
+}
+
+/* Waits for a job to be queued. Returns 0 once the pool shuts down */
+static int Sleep(wpool_t *pool)
+{
+	int keep_running = 1;
+
+	assert(pool);
+
+	pthread_mutex_lock(&pool->lock);
+
+	atomic_fetch_add(&pool->sleepers, 1);
+	while (0 == atomic_load(&pool->queued) && !pool->shutdown)
+	{
+		pthread_cond_wait(&pool->cond, &pool->lock);
+	}
+	atomic_fetch_sub(&pool->sleepers, 1);
+
+	keep_running = (0 != atomic_load(&pool->queued) || !pool->shutdown);
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return (keep_running);
+}
+
+static void *WorkerMain(void *arg)
+{
+	worker_t *self = (worker_t *)arg;
+	wpool_t *pool = self->pool;
+	void *job = NULL;
+
+	do
+	{
+		pthread_mutex_lock(&self->deque.lock);
+		job = DequePopFront(&self->deque);
+		pthread_mutex_unlock(&self->deque.lock);
+
+		if (!job)
+		{
+			job = Steal(pool, self->id);
+		}
+
+		if (job)
+		{
+			atomic_fetch_sub(&pool->queued, 1);
+			pool->job_func(job, pool->param);
+		}
+	} while (job || Sleep(pool));
+
+	return (NULL);
+}
+
+/* Stops and joins the first n_started workers and frees the pool */
+static void StopWorkers(wpool_t *pool, size_t n_started)
+{
+	size_t i = 0;
+
+	assert(pool);
+
+	pthread_mutex_lock(&pool->lock);
+	pool->shutdown = 1;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (i = 0; i < n_started; ++i)
+	{
+		pthread_join(pool->workers[i].thread, NULL);
+	}
+
+	FreePool(pool, pool->n_workers);
+}
+
+/* Frees the pool along with the first n_deques deques */
+static void FreePool(wpool_t *pool, size_t n_deques)
+{
+	size_t i = 0;
+
+	assert(pool);
+
+	for (i = 0; i < n_deques; ++i)
+	{
+		DequeDestroy(&pool->workers[i].deque);
+	}
+
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->workers);
+	free(pool);
+}
@@ -0,0 +1,97 @@
+/*
+	Name: Guy Feigin
+	Exercise: Timing wheel test
+	File Type: Source code
+	Reviewer:
+	Last Updated: Sun 18 Oct 2026 09:40:12
+*/
+
+#include <stdio.h> /* printf() */
+#include <stdlib.h> /* EXIT_FAILURE */
+
+#include "twheel.h" /* twheel_t */
+
+#define LEVELS (4)
+#define SLOT_BITS (6)
+#define NO_TICK ((size_t)-1)
+
+static size_t KeyOf(const void *data);
+static int TestDeadline(size_t now, size_t deadline);
+
+int main(void)
+{
+	static const size_t starts[] = {0, 1, 37, 63, 64, 4095, 100000};
+	size_t boundary = 0;
+	size_t level = 0;
+	size_t i = 0;
+	long offset = 0;
+	int failures = 0;
+
+	/* Just below and above every 64^l, from now and as an absolute tick */
+	for (level = 1; level < LEVELS; ++level)
+	{
+		boundary = (size_t)1 << (SLOT_BITS * level);
+
+		for (i = 0; i < sizeof(starts) / sizeof(starts[0]); ++i)
+		{
+			for (offset = -2; offset <= 2; ++offset)
+			{
+				failures += TestDeadline(starts[i], 
+										 starts[i] + boundary + offset);
+				if (starts[i] < boundary + offset)
+				{
+					failures += TestDeadline(starts[i], boundary + offset);
+				}
+			}
+		}
+	}
+
+	printf("twheel: %d failures\n", failures);
+
+	return (0 == failures ? 0 : EXIT_FAILURE);
+}
+
+static size_t KeyOf(const void *data)
+{
+	return (*(const size_t *)data);
+}
+
+/* Follows TWNextTick from now, it must never skip past the deadline */
+static int TestDeadline(size_t now, size_t deadline)
+{
+	twheel_t *tw = TWCreate(KeyOf, now);
+	size_t next = 0;
+	int status = 0;
+
+	if (NULL == tw || NULL == TWInsert(tw, &deadline))
+	{
+		printf("now %lu deadline %lu: out of memory\n", now, deadline);
+		TWDestroy(tw);
+		return (1);
+	}
+
+	while (NULL == TWPopExpired(tw))
+	{
+		next = TWNextTick(tw);
+		if (NO_TICK == next || next > deadline)
+		{
+			printf("now %lu deadline %lu: next tick %lu at %lu\n", now, 
+				   deadline, next, TWNow(tw));
+			status = 1;
+			break;
+		}
+
+		TWAdvance(tw, next);
+	}
+
+	if (0 == status && TWNow(tw) != deadline)
+	{
+		printf("now %lu deadline %lu: expired at %lu\n", now, deadline, 
+			   TWNow(tw));
+		status = 1;
+	}
+
+	TWDestroy(tw);
+
+	return (status);
+}